@@ -30,9 +30,36 @@
  * GNU Lesser General Public License for more details.
  */
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <limits>
+
+#include <unistd.h>
+
 #include "gtest/gtest.h"
 
 #include "regression_tests/laplace.cpp"
+#include "regression_tests/transient_diffusion.cpp"
+#include "regression_tests/nonlinear_reaction.cpp"
+#include "regression_tests/convection_dominated.cpp"
+#include "regression_tests/heterogeneous.cpp"
+#include "regression_tests/adaptive.cpp"
+#include "regression_tests/coupled_system.cpp"
+#include "regression_tests/snapshot_multigrid.h"
+#include "regression_tests/manufactured_solution.cpp"
+#include "regression_tests/dirichlet_sweep.cpp"
+#include "regression_tests/gmg_tuner.h"
+#include "regression_tests/galerkin_product.h"
+#include "regression_tests/transfer_benchmark.h"
+#include "regression_tests/benchmark_runner.h"
+#include "regression_tests/history_recorder.h"
+#include "regression_tests/trace_recorder.h"
+#include "regression_tests/sampling_profiler.h"
+#include "regression_tests/energy_meter.h"
+#include "lib_algebra/algebra_common/sparsematrix_util.h"
 
 namespace ug {
 namespace test {
@@ -45,11 +72,978 @@ TEST(Laplace, RegressionTests)
 
     std::string grid = "../plugins/UG4Tests/regression_tests/grids/laplace_sphere_3d.ugx";
     std::string reference = "../plugins/UG4Tests/regression_tests/references/laplace.txt";
-    Laplace Testcase(grid, reference);
+    Laplace<3> Testcase(grid, reference);
+    Testcase.run();
+
+    EXPECT_TRUE(Testcase.check_residual());
+    EXPECT_TRUE(Testcase.compare());
+}
+
+TEST(Laplace2d, SmokeTests)
+{
+    #ifdef UG_PARALLEL
+		pcl::Init(nullptr, nullptr);
+	#endif
+
+    std::string grid = "../plugins/UG4Tests/regression_tests/grids/laplace_square_2d.ugx";
+    std::string reference = "../plugins/UG4Tests/regression_tests/references/laplace_2d.bin";
+    Laplace<2> Testcase(grid, reference);
+    Testcase.set_num_refs(5);
+    Testcase.run();
+
+    EXPECT_TRUE(Testcase.check_residual());
+    EXPECT_TRUE(Testcase.compare());
+}
+
+TEST(TransientDiffusion, RegressionTests)
+{
+    #ifdef UG_PARALLEL
+		pcl::Init(nullptr, nullptr);
+	#endif
+
+    std::string grid = "../plugins/UG4Tests/regression_tests/grids/laplace_sphere_3d.ugx";
+    std::string reference = "../plugins/UG4Tests/regression_tests/references/transient_diffusion.bin";
+    TransientDiffusion<3> Testcase(grid, reference);
+    Testcase.set_num_refs(3);
+    Testcase.run();
+    Testcase.print_timings();
+
+    // the operator is constant in time, so it is assembled and the GMG set up only once
+    EXPECT_EQ(Testcase.phase_calls().at("assembly"), 1u);
+    EXPECT_EQ(Testcase.phase_calls().at("solver setup"), 1u);
+
+    TransientDiffusion<3> Rebuilding(grid, reference);
+    Rebuilding.set_num_refs(3);
+    Rebuilding.set_reuse_operator(false);
+    Rebuilding.run();
+    Rebuilding.print_timings();
+
+    double reused = Testcase.timings().at("assembly") + Testcase.timings().at("assembly rhs") + Testcase.timings().at("solver setup");
+    double rebuilt = Rebuilding.timings().at("assembly") + Rebuilding.timings().at("solver setup");
+    std::cout << "assembly and setup: " << reused << " s with reuse, " << rebuilt << " s without" << std::endl;
+    std::cout << "solve: " << Testcase.timings().at("solve") << " s with reuse, "
+              << Rebuilding.timings().at("solve") << " s without" << std::endl;
+
+    EXPECT_EQ(Testcase.num_iterations(), Rebuilding.num_iterations());
+
+    EXPECT_TRUE(Testcase.compare());
+    EXPECT_TRUE(Rebuilding.compare());
+}
+
+TEST(NonlinearReaction, RegressionTests)
+{
+    #ifdef UG_PARALLEL
+		pcl::Init(nullptr, nullptr);
+	#endif
+
+    std::string grid = "../plugins/UG4Tests/regression_tests/grids/laplace_sphere_3d.ugx";
+    std::string reference = "../plugins/UG4Tests/regression_tests/references/nonlinear_reaction.bin";
+    std::string history = "../plugins/UG4Tests/regression_tests/references/nonlinear_reaction_history.txt";
+    NonlinearReaction<3> Testcase(grid, reference);
+    Testcase.set_history_reference(history);
+    Testcase.run();
+    Testcase.print_timings();
+
+    for (size_t i = 0; i < Testcase.history().size(); i++)
+        std::cout << "Newton step " << i << ": defect " << Testcase.history()[i] << std::endl;
+
+    EXPECT_TRUE(Testcase.compare());
+    EXPECT_TRUE(Testcase.compare_history());
+}
+
+TEST(ConvectionDominated, RegressionTests)
+{
+    #ifdef UG_PARALLEL
+		pcl::Init(nullptr, nullptr);
+	#endif
+
+    std::string grid = "../plugins/UG4Tests/regression_tests/grids/laplace_sphere_3d.ugx";
+    std::string reference = "../plugins/UG4Tests/regression_tests/references/convection_dominated.bin";
+    ConvectionDominated<3> Testcase(grid, reference);
     Testcase.run();
 
+    const std::vector<number> &history = Testcase.last_solve().history;
+    for (size_t i = 0; i < history.size(); i++)
+        std::cout << "BiCGStab step " << i << ": defect " << history[i] << std::endl;
+
+    // benchmark smoothers and number of smoothing steps on the assembled system
+    const char *smoothers[] = {"jacobi", "gs", "sgs", "ilu"};
+    const int numSmooth[] = {1, 3};
+    int bestIterations = -1;
+    for (const char *smoother : smoothers)
+    {
+        for (int nu : numSmooth)
+        {
+            GMGSettings settings;
+            settings.smoother = smoother;
+            settings.numPreSmooth = nu;
+            settings.numPostSmooth = nu;
+
+            SolveStatistics stats = Testcase.solve(settings);
+            std::cout << std::setw(8) << smoother << " nu = " << nu << ": "
+                      << std::setw(4) << stats.iterations << " iterations, "
+                      << stats.seconds << " s" << (stats.converged ? "" : " (not converged)") << std::endl;
+
+            if (stats.converged && (bestIterations < 0 || stats.iterations < bestIterations))
+                bestIterations = stats.iterations;
+        }
+    }
+
+    // iteration blow-up of the default configuration or of all smoothers fails the test
+    EXPECT_LE(Testcase.last_solve().iterations, 50);
+    EXPECT_GE(bestIterations, 0);
+    EXPECT_LE(bestIterations, 20);
+
     EXPECT_TRUE(Testcase.compare());
 }
 
+TEST(Heterogeneous, RegressionTests)
+{
+    #ifdef UG_PARALLEL
+		pcl::Init(nullptr, nullptr);
+	#endif
+
+    std::string grid = "../plugins/UG4Tests/regression_tests/grids/laplace_sphere_3d_jump.ugx";
+    std::string reference = "../plugins/UG4Tests/regression_tests/references/heterogeneous.bin";
+
+    // iteration and time budget (GMG setup and solve) per refinement level, the
+    // iteration budgets are hard limits, the time budgets depend on the machine and
+    // are only checked with --benchmark
+    struct Budget
+    {
+        int numRefs;
+        int iterations;
+        double seconds;
+    };
+    const Budget budgets[] = {{1, 20, 0.5}, {2, 20, 1.0}, {3, 25, 5.0}, {4, 25, 30.0}};
+
+    for (const Budget &budget : budgets)
+    {
+        Heterogeneous<3> Testcase(grid, reference);
+        Testcase.set_num_refs(budget.numRefs);
+        Testcase.run();
+
+        const SolveStatistics &stats = Testcase.statistics();
+        std::cout << "refinements: " << budget.numRefs << ", iterations: " << stats.iterations
+                  << ", time: " << stats.seconds << " s" << std::endl;
+
+        EXPECT_TRUE(stats.converged);
+        EXPECT_LE(stats.iterations, budget.iterations) << "at " << budget.numRefs << " refinements";
+        if (GlobalBenchmarkOptions().enabled)
+            EXPECT_LE(stats.seconds, budget.seconds) << "at " << budget.numRefs << " refinements";
+        else if (stats.seconds > budget.seconds)
+            std::cout << "time budget of " << budget.seconds << " s exceeded at " << budget.numRefs
+                      << " refinements" << std::endl;
+
+        if (budget.numRefs != budgets[3].numRefs)
+            continue;
+
+        EXPECT_TRUE(Testcase.compare());
+    }
+}
+
+TEST(Adaptive, RegressionTests)
+{
+    #ifdef UG_PARALLEL
+		pcl::Init(nullptr, nullptr);
+	#endif
+
+    std::string grid = "../plugins/UG4Tests/regression_tests/grids/laplace_sphere_3d.ugx";
+    std::string reference = "../plugins/UG4Tests/regression_tests/references/adaptive.bin";
+    Adaptive<3> Testcase(grid, reference);
+    Testcase.run();
+
+    const std::vector<Adaptive<3>::Cycle> &cycles = Testcase.cycles();
+    for (size_t i = 0; i < cycles.size(); i++)
+    {
+        std::cout << "cycle " << i << ": " << std::setw(8) << cycles[i].numDoFs << " DoFs, "
+                  << cycles[i].iterations << " iterations, solve " << cycles[i].solveSeconds
+                  << " s, estimate " << cycles[i].estimateSeconds << " s, mark " << cycles[i].markSeconds << " s, refine " << cycles[i].refineSeconds << " s" << std::endl;
+    }
+    std::cout << "globally refined: " << Testcase.global_dofs() << " DoFs, max. nodal difference: "
+              << Testcase.max_error() << std::endl;
+
+    // adaptivity has to save DoFs without losing the solution at the interface
+    EXPECT_LT(cycles.back().numDoFs, Testcase.global_dofs());
+    EXPECT_LT(Testcase.max_error(), 0.05);
+
+    EXPECT_TRUE(Testcase.compare());
+}
+
+TEST(CoupledSystem, RegressionTests)
+{
+    #ifdef UG_PARALLEL
+		pcl::Init(nullptr, nullptr);
+	#endif
+
+    std::string grid = "../plugins/UG4Tests/regression_tests/grids/laplace_sphere_3d.ugx";
+    std::string reference = "../plugins/UG4Tests/regression_tests/references/coupled_system.bin";
+
+    CoupledSystem<3, CPUAlgebra> Scalar(grid, reference);
+    Scalar.set_num_refs(3);
+    Scalar.run();
+
+    CoupledSystem<3, CPUBlockAlgebra<3>> Block(grid, reference);
+    Block.set_num_refs(3);
+    Block.run();
+
+    const char *phases[] = {"assembly", "spmv", "smoother", "solve"};
+    for (const char *phase : phases)
+    {
+        std::cout << std::setw(10) << phase << ": CPUAlgebra " << Scalar.timings().at(phase)
+                  << " s, CPUBlockAlgebra<3> " << Block.timings().at(phase) << " s" << std::endl;
+    }
+    std::cout << "iterations: CPUAlgebra " << Scalar.num_iterations()
+              << ", CPUBlockAlgebra<3> " << Block.num_iterations() << std::endl;
+
+    // both algebras have to yield the same solution up to the solver accuracy: each
+    // solve only reduces the defect by 1e-6, the error is larger by about the
+    // condition number, so they are compared relative to the size of the solution
+    ASSERT_EQ(Scalar.solution().size(), Block.solution().size());
+    double maxValue = 0.0;
+    for (size_t i = 0; i < Scalar.solution().size(); i++)
+        maxValue = std::max(maxValue, std::abs(Scalar.solution()[i]));
+    for (size_t i = 0; i < Scalar.solution().size(); i++)
+        ASSERT_NEAR(Scalar.solution()[i], Block.solution()[i], 1e-3 * maxValue) << "at " << i;
+
+    // the block algebra is checked against the scalar solution above, the reference
+    // holds the scalar solution
+    EXPECT_TRUE(Scalar.compare());
+}
+
+TEST(LaplaceSnapshot, SolverBenchmark)
+{
+    #ifdef UG_PARALLEL
+		pcl::Init(nullptr, nullptr);
+	#endif
+
+    std::string grid = "../plugins/UG4Tests/regression_tests/grids/laplace_sphere_3d.ugx";
+    std::string reference = "../plugins/UG4Tests/regression_tests/references/laplace.txt";
+    char snapshotFile[] = "/tmp/ug4tests_snapshot_XXXXXX";
+    int fd = mkstemp(snapshotFile);
+    ASSERT_NE(fd, -1);
+    close(fd);
+
+    const int numRefs = 4;
+    Laplace<3> Testcase(grid, reference);
+    Testcase.set_num_refs(numRefs);
+    Testcase.run();
+    Testcase.export_snapshot(snapshotFile);
+
+    double setup = 0.0;
+    const char *phases[] = {"load domain", "refine", "approximation space", "assembly"};
+    for (const char *phase : phases)
+        setup += Testcase.timings().at(phase);
+
+    // reload the system and solve it without grid and discretization
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Snapshot snap;
+    ReadSnapshot(snapshotFile, snap);
+    std::chrono::duration<double> reload = std::chrono::steady_clock::now() - start;
+    std::remove(snapshotFile);
+
+    SmartPtr<Snapshot::TOperator> A = snap.levelMatrices.back();
+    SmartPtr<StdConvCheck<Snapshot::vector_type>> convCheck = make_sp(new StdConvCheck<Snapshot::vector_type>(100, 1e-12, 1e-6, false));
+    BiCGStab<Snapshot::vector_type> solver;
+    solver.set_preconditioner(make_sp(new SnapshotMultigrid(snap)));
+    solver.set_convergence_check(convCheck);
+
+    start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(solver.init(A, *snap.spU));
+    ASSERT_TRUE(solver.apply(*snap.spU, *snap.spB));
+    std::chrono::duration<double> solve = std::chrono::steady_clock::now() - start;
+
+    std::cout << "setup from grid: " << setup << " s, reload from snapshot: " << reload.count()
+              << " s, solve: " << solve.count() << " s (" << convCheck->step() << " iterations)" << std::endl;
+
+    // one matrix for the base grid and each refinement
+    EXPECT_EQ(snap.levelMatrices.size(), static_cast<size_t>(numRefs + 1));
+    EXPECT_FALSE(snap.dirichletRows.empty());
+    for (size_t i = 0; i < snap.dirichletRows.size(); i++)
+        EXPECT_EQ((*snap.spU)[snap.dirichletRows[i]], (*snap.spB)[snap.dirichletRows[i]]);
+    EXPECT_LT(reload.count(), setup);
+}
+
+TEST(ManufacturedSolution, RegressionTests)
+{
+    #ifdef UG_PARALLEL
+		pcl::Init(nullptr, nullptr);
+	#endif
+
+    std::string grid = "../plugins/UG4Tests/regression_tests/grids/laplace_sphere_3d.ugx";
+
+    // error versus wall clock time over the refinement levels
+    number lastError = 0.0;
+    for (int numRefs = 1; numRefs <= 4; numRefs++)
+    {
+        ManufacturedSolution<3> Testcase(grid);
+        Testcase.set_num_refs(numRefs);
+        Testcase.run();
+
+        std::cout << "refinements: " << numRefs << ", DoFs: " << std::setw(8) << Testcase.num_dofs()
+                  << ", L2 error: " << Testcase.l2_error() << ", time: " << Testcase.seconds() << " s";
+
+        if (numRefs > 1)
+        {
+            // P1 elements converge with second order in the L2 norm, the coarsest grid
+            // is not yet in the asymptotic range
+            const number order = std::log2(lastError / Testcase.l2_error());
+            std::cout << ", order: " << order;
+            if (numRefs > 2)
+                EXPECT_GT(order, 1.8) << "at " << numRefs << " refinements";
+        }
+        std::cout << std::endl;
+
+        lastError = Testcase.l2_error();
+    }
+}
+
+TEST(LaplaceNestedIteration, RegressionTests)
+{
+    #ifdef UG_PARALLEL
+		pcl::Init(nullptr, nullptr);
+	#endif
+
+    std::string grid = "../plugins/UG4Tests/regression_tests/grids/laplace_sphere_3d.ugx";
+    std::string reference = "../plugins/UG4Tests/regression_tests/references/laplace.txt";
+    Laplace<3> ZeroGuess(grid, reference);
+    ZeroGuess.run();
+
+    Laplace<3> Nested(grid, reference);
+    Nested.set_nested_iteration(true);
+    Nested.run();
+
+    const double zeroTime = ZeroGuess.timings().at("solve");
+    const double nestedTime = Nested.timings().at("nested iteration") + Nested.timings().at("solve");
+    std::cout << "zero initial guess: " << ZeroGuess.num_iterations() << " iterations, " << zeroTime << " s" << std::endl;
+    std::cout << "nested iteration:   " << Nested.num_iterations() << " iterations, " << nestedTime
+              << " s (" << Nested.timings().at("nested iteration") << " s on the coarser levels)" << std::endl;
+
+    EXPECT_LT(Nested.num_iterations(), ZeroGuess.num_iterations());
+    EXPECT_TRUE(Nested.check_residual());
+    EXPECT_TRUE(ZeroGuess.compare());
+
+    // both runs reach the same absolute defect and have to agree within the solver tolerance
+    const CPUAlgebra::vector_type &uZero = *ZeroGuess.solution_function();
+    const CPUAlgebra::vector_type &uNested = *Nested.solution_function();
+    ASSERT_EQ(uZero.size(), uNested.size());
+    for (size_t i = 0; i < uZero.size(); i++)
+        ASSERT_NEAR(uZero[i], uNested[i], 1e-4) << "at " << i;
+}
+
+TEST(LaplacePipelined, RegressionTests)
+{
+    #ifdef UG_PARALLEL
+		pcl::Init(nullptr, nullptr);
+	#endif
+
+    std::string grid = "../plugins/UG4Tests/regression_tests/grids/laplace_sphere_3d.ugx";
+    std::string reference = "../plugins/UG4Tests/regression_tests/references/laplace.txt";
+    Laplace<3> Standard(grid, reference);
+    Standard.run();
+
+    Laplace<3> Pipelined(grid, reference);
+    Pipelined.set_krylov_method("pipelined");
+    Pipelined.run();
+
+    int numProcs = 1;
+    #ifdef UG_PARALLEL
+    numProcs = pcl::NumProcs();
+    #endif
+    std::cout << "processes: " << numProcs << std::endl;
+    std::cout << "BiCGStab:           " << Standard.num_iterations() << " iterations, " << Standard.timings().at("solve") << " s" << std::endl;
+    std::cout << "PipelinedBiCGStab:  " << Pipelined.num_iterations() << " iterations, " << Pipelined.timings().at("solve") << " s" << std::endl;
+
+    // the pipelined variant rounds differently and stops at a different iterate, so it
+    // is checked against the standard run at the solver tolerance, not the reference
+    EXPECT_TRUE(Pipelined.check_residual());
+    const CPUAlgebra::vector_type &uStandard = *Standard.solution_function();
+    const CPUAlgebra::vector_type &uPipelined = *Pipelined.solution_function();
+    ASSERT_EQ(uStandard.size(), uPipelined.size());
+    for (size_t i = 0; i < uStandard.size(); i++)
+        ASSERT_NEAR(uStandard[i], uPipelined[i], 1e-4) << "at " << i;
+}
+
+TEST(LaplaceFused, RegressionTests)
+{
+    #ifdef UG_PARALLEL
+		pcl::Init(nullptr, nullptr);
+	#endif
+
+    std::string grid = "../plugins/UG4Tests/regression_tests/grids/laplace_sphere_3d.ugx";
+    std::string reference = "../plugins/UG4Tests/regression_tests/references/laplace.txt";
+    const std::vector<std::string> methods = {"bicgstab", "fused-bicgstab", "cg", "fused-cg"};
+
+    for (int numRefs = 2; numRefs <= 4; numRefs++)
+    {
+        std::vector<SmartPtr<Laplace<3>>> runs;
+        for (const std::string &method : methods)
+        {
+            SmartPtr<Laplace<3>> Testcase = make_sp(new Laplace<3>(grid, reference));
+            Testcase->set_num_refs(numRefs);
+            Testcase->set_krylov_method(method);
+            Testcase->run();
+            EXPECT_TRUE(Testcase->check_residual()) << method << ", " << numRefs << " refinements";
+            runs.push_back(Testcase);
+        }
+
+        const CPUAlgebra::vector_type &uBase = *runs[0]->solution_function();
+        std::cout << numRefs << " refinements, " << uBase.size() << " DoFs" << std::endl;
+        for (size_t m = 0; m < methods.size(); m++)
+        {
+            std::cout << "  " << methods[m] << ": " << runs[m]->num_iterations() << " iterations, "
+                      << runs[m]->timings().at("solve") << " s" << std::endl;
+
+            // all variants have to agree within the solver tolerance
+            const CPUAlgebra::vector_type &u = *runs[m]->solution_function();
+            ASSERT_EQ(uBase.size(), u.size());
+            for (size_t i = 0; i < u.size(); i++)
+                ASSERT_NEAR(uBase[i], u[i], 1e-4) << methods[m] << " at " << i;
+        }
+    }
+}
+
+TEST(BaseSolver, SolverBenchmark)
+{
+    #ifdef UG_PARALLEL
+		pcl::Init(nullptr, nullptr);
+	#endif
+
+    std::string grid = "../plugins/UG4Tests/regression_tests/grids/laplace_sphere_3d.ugx";
+    std::string reference = "../plugins/UG4Tests/regression_tests/references/laplace.txt";
+    const std::vector<std::string> baseSolvers = {"superlu", "lu", "cg"};
+
+    for (int baseLevel = 0; baseLevel <= 2; baseLevel++)
+    {
+        std::string fastest;
+        double fastestTime = std::numeric_limits<double>::max();
+        for (const std::string &baseSolver : baseSolvers)
+        {
+            GMGSettings settings;
+            settings.baseLevel = baseLevel;
+            settings.baseSolver = baseSolver;
+            settings.baseSolverTimings = make_sp(new SolverTimings());
+
+            Laplace<3> Testcase(grid, reference);
+            Testcase.set_gmg_settings(settings);
+            Testcase.run();
+            EXPECT_TRUE(Testcase.check_residual()) << baseSolver << " on base level " << baseLevel;
+
+            const SolverTimings &timings = *settings.baseSolverTimings;
+            const double solveTime = Testcase.timings().at("solver setup") + Testcase.timings().at("solve");
+            std::cout << "base level " << baseLevel << ", " << baseSolver << ": "
+                      << "setup " << timings.initSeconds << " s, "
+                      << timings.numApply << " cycles at " << timings.seconds_per_apply() << " s, "
+                      << Testcase.num_iterations() << " iterations, setup and solve " << solveTime << " s" << std::endl;
+
+            if (solveTime < fastestTime)
+            {
+                fastestTime = solveTime;
+                fastest = baseSolver;
+            }
+        }
+        std::cout << "base level " << baseLevel << ": fastest base solver is " << fastest << std::endl;
+    }
+}
+
+TEST(LaplaceTuner, AutoTuning)
+{
+    #ifdef UG_PARALLEL
+		pcl::Init(nullptr, nullptr);
+	#endif
+
+    // grid and refinement can be overridden to tune for another geometry, the optimum
+    // is only kept if a config file is given
+    std::string grid = "../plugins/UG4Tests/regression_tests/grids/laplace_sphere_3d.ugx";
+    int numRefs = 4;
+    if (const char *env = std::getenv("UG4TESTS_TUNE_GRID"))
+        grid = env;
+    if (const char *env = std::getenv("UG4TESTS_TUNE_REFS"))
+        numRefs = std::atoi(env);
+    std::string reference = "../plugins/UG4Tests/regression_tests/references/laplace.txt";
+    char tempConfig[] = "/tmp/ug4tests_gmg_XXXXXX";
+    const char *keptConfig = std::getenv("UG4TESTS_TUNE_CONFIG");
+    std::string config = keptConfig ? keptConfig : "";
+    if (!keptConfig)
+    {
+        int fd = mkstemp(tempConfig);
+        ASSERT_NE(fd, -1);
+        close(fd);
+        config = tempConfig;
+    }
+
+    Laplace<3> Testcase(grid, reference);
+    Testcase.set_num_refs(numRefs);
+    Testcase.run();
+
+    GMGTuner Tuner([&Testcase](const GMGSettings &settings, double timeLimit)
+                   { return Testcase.solve(settings, timeLimit); });
+    const GMGSettings start;
+    const GMGSettings best = Tuner.tune(start);
+
+    for (const TuningResult &result : Tuner.results())
+    {
+        const GMGSettings &s = result.settings;
+        std::cout << "base level " << s.baseLevel << ", " << s.numPreSmooth << "/" << s.numPostSmooth
+                  << " smoothing steps, damping " << s.damping << ", " << s.cycleType << "-cycle: ";
+        if (result.stats.converged)
+            std::cout << result.stats.iterations << " iterations, " << result.stats.seconds << " s" << std::endl;
+        else
+            std::cout << (result.terminated ? "terminated early" : "failed") << std::endl;
+    }
+    Tuner.write_config(config);
+    std::cout << "optimum " << Tuner.best_seconds() << " s (initial settings " << Tuner.results().front().stats.seconds
+              << " s), written to " << config << std::endl;
+
+    // the optimum was selected on the timings of the search, so it is compared with the
+    // initial settings on new ones, which are free of that selection bias; as a wall
+    // clock check only under --benchmark
+    const int numSamples = 5;
+    std::vector<double> startSeconds, bestSeconds;
+    for (int i = 0; i < numSamples; i++)
+    {
+        startSeconds.push_back(Testcase.solve(start).seconds);
+        bestSeconds.push_back(Testcase.solve(best).seconds);
+    }
+    std::cout << "remeasured: optimum " << Median(bestSeconds) << " s, initial settings "
+              << Median(startSeconds) << " s" << std::endl;
+    if (GlobalBenchmarkOptions().enabled)
+        EXPECT_LE(Median(bestSeconds), 1.1 * Median(startSeconds));
+    else if (Median(bestSeconds) > 1.1 * Median(startSeconds))
+        std::cout << "optimum slower than the initial settings" << std::endl;
+
+    // the config reproduces the optimum
+    const GMGSettings read = ReadGMGSettings(config);
+    if (!keptConfig)
+        std::remove(config.c_str());
+    EXPECT_EQ(read.baseLevel, best.baseLevel);
+    EXPECT_EQ(read.numPreSmooth, best.numPreSmooth);
+    EXPECT_EQ(read.numPostSmooth, best.numPostSmooth);
+    EXPECT_NEAR(read.damping, best.damping, 1e-12);
+    EXPECT_EQ(read.cycleType, best.cycleType);
+    EXPECT_TRUE(Testcase.solve(read).converged);
+}
+
+TEST(LaplaceRAP, RegressionTests)
+{
+    #ifdef UG_PARALLEL
+		pcl::Init(nullptr, nullptr);
+	#endif
+
+    std::string grid = "../plugins/UG4Tests/regression_tests/grids/laplace_sphere_3d.ugx";
+    std::string reference = "../plugins/UG4Tests/regression_tests/references/laplace.txt";
+    Laplace<3> Rediscretized(grid, reference);
+    Rediscretized.run();
+
+    // coarse operators as Galerkin products R A P of UG4 instead of rediscretization
+    GMGSettings settings;
+    settings.rap = true;
+    Laplace<3> Galerkin(grid, reference);
+    Galerkin.set_gmg_settings(settings);
+    Galerkin.run();
+
+    std::cout << "rediscretized: " << Rediscretized.num_iterations() << " iterations, " << Rediscretized.timings().at("solver setup") << " s setup" << std::endl;
+    std::cout << "Galerkin:      " << Galerkin.num_iterations() << " iterations, " << Galerkin.timings().at("solver setup") << " s setup" << std::endl;
+
+    // both solve the same fine system, to the accuracy of the solver
+    EXPECT_TRUE(Galerkin.check_residual());
+    const CPUAlgebra::vector_type &uRediscretized = *Rediscretized.solution_function();
+    const CPUAlgebra::vector_type &uGalerkin = *Galerkin.solution_function();
+    ASSERT_EQ(uRediscretized.size(), uGalerkin.size());
+    for (size_t i = 0; i < uGalerkin.size(); i++)
+        ASSERT_NEAR(uRediscretized[i], uGalerkin[i], 1e-4) << "at " << i;
+
+    // the snapshot multigrid with rediscretized coarse operators and with coarse
+    // operators computed by GalerkinProduct
+    Snapshot snap;
+    Rediscretized.build_snapshot(snap);
+    SmartPtr<Snapshot::TOperator> A = snap.levelMatrices.back();
+    const Snapshot::vector_type &b = *snap.spB;
+    Snapshot::vector_type r(b.size());
+    A->apply(r, *snap.spU);
+    VecScaleAdd(r, 1.0, b, -1.0, r);
+    const double initialResidual = r.norm();
+
+    for (bool galerkin : {false, true})
+    {
+        SmartPtr<SnapshotMultigrid> Multigrid = make_sp(new SnapshotMultigrid(snap));
+        Multigrid->set_galerkin(galerkin);
+        SmartPtr<StdConvCheck<Snapshot::vector_type>> convCheck = make_sp(new StdConvCheck<Snapshot::vector_type>(100, 1e-12, 1e-6, false));
+        BiCGStab<Snapshot::vector_type> solver;
+        solver.set_preconditioner(Multigrid);
+        solver.set_convergence_check(convCheck);
+
+        Snapshot::vector_type u(b.size());
+        VecScaleAssign(u, 1.0, *snap.spU);
+        ASSERT_TRUE(solver.init(A, u));
+        ASSERT_TRUE(solver.apply(u, b)) << (galerkin ? "Galerkin" : "rediscretized");
+        std::cout << "snapshot multigrid, " << (galerkin ? "GalerkinProduct: " : "rediscretized:   ")
+                  << convCheck->step() << " iterations" << std::endl;
+
+        A->apply(r, u);
+        VecScaleAdd(r, 1.0, b, -1.0, r);
+        EXPECT_LE(r.norm(), 1.01 * std::max(1e-12, 1e-6 * initialResidual));
+    }
+}
+
+TEST(GalerkinProduct, SolverBenchmark)
+{
+    #ifdef UG_PARALLEL
+		pcl::Init(nullptr, nullptr);
+	#endif
+
+    typedef CPUAlgebra::matrix_type matrix_type;
+    typedef std::chrono::steady_clock clock;
+
+    std::string grid = "../plugins/UG4Tests/regression_tests/grids/laplace_sphere_3d.ugx";
+    std::string reference = "../plugins/UG4Tests/regression_tests/references/laplace.txt";
+    Laplace<3> Testcase(grid, reference);
+    Testcase.run();
+
+    Snapshot snap;
+    Testcase.build_snapshot(snap);
+
+    for (size_t lev = snap.levelMatrices.size() - 1; lev > 0; lev--)
+    {
+        const matrix_type &R = *snap.restrictions[lev - 1];
+        const matrix_type &A = *snap.levelMatrices[lev];
+        const matrix_type &P = *snap.prolongations[lev - 1];
+
+        // UG4 triple product
+        matrix_type AcUG;
+        clock::time_point start = clock::now();
+        CreateAsMultiplyOf(AcUG, R, A, P);
+        const std::chrono::duration<double> ug4Time = clock::now() - start;
+        const size_t ug4Memory = AcUG.total_num_connections() * (sizeof(double) + sizeof(size_t)) + AcUG.num_rows() * sizeof(size_t);
+
+        // cached symbolic phase, threaded numeric phase
+        GalerkinProduct Product;
+        matrix_type Ac;
+        start = clock::now();
+        Product.symbolic(R, A, P);
+        const std::chrono::duration<double> symbolicTime = clock::now() - start;
+        start = clock::now();
+        Product.numeric(R, A, P);
+        const std::chrono::duration<double> numericTime = clock::now() - start;
+        start = clock::now();
+        Product.copy_to(Ac);
+        const std::chrono::duration<double> copyTime = clock::now() - start;
+
+        std::cout << "level " << lev << " -> " << lev - 1 << ": " << Ac.num_rows() << " coarse rows, " << Product.num_nonzeros() << " non-zeros" << std::endl;
+        std::cout << "  UG4:             " << ug4Time.count() << " s, " << ug4Memory << " bytes" << std::endl;
+        std::cout << "  GalerkinProduct: symbolic " << symbolicTime.count() << " s, numeric " << numericTime.count()
+                  << " s, copy " << copyTime.count() << " s, " << Product.memory() << " bytes" << std::endl;
+
+        // both products have to agree
+        ASSERT_EQ(Ac.num_rows(), AcUG.num_rows());
+        ASSERT_EQ(Ac.num_cols(), AcUG.num_cols());
+        for (size_t i = 0; i < Ac.num_rows(); i++)
+        {
+            // const access, the non-const operator() would insert missing entries
+            const matrix_type &constAc = Ac;
+            const matrix_type &constAcUG = AcUG;
+            for (matrix_type::const_row_iterator it = Ac.begin_row(i); it != Ac.end_row(i); ++it)
+                ASSERT_NEAR(it.value(), constAcUG(i, it.index()), 1e-10) << "at (" << i << ", " << it.index() << ")";
+            for (matrix_type::const_row_iterator it = AcUG.begin_row(i); it != AcUG.end_row(i); ++it)
+                ASSERT_NEAR(it.value(), constAc(i, it.index()), 1e-10) << "at (" << i << ", " << it.index() << ")";
+        }
+    }
+}
+
+TEST(Transfer, SolverBenchmark)
+{
+    #ifdef UG_PARALLEL
+		pcl::Init(nullptr, nullptr);
+	#endif
+
+    std::string grid = "../plugins/UG4Tests/regression_tests/grids/laplace_sphere_3d.ugx";
+    std::string reference = "../plugins/UG4Tests/regression_tests/references/laplace.txt";
+    Laplace<3> Optimized(grid, reference);
+    Optimized.run();
+
+    GMGSettings settings;
+    settings.p1LagrangeOptimization = false;
+    Laplace<3> Generic(grid, reference);
+    Generic.set_gmg_settings(settings);
+    Generic.run();
+
+    // the optimization must not change the Laplace result, up to rounding, which may
+    // move the stopping criterion by an iteration
+    EXPECT_TRUE(Generic.check_residual());
+    EXPECT_LE(std::abs(Optimized.num_iterations() - Generic.num_iterations()), 1);
+    const double tolerance = Optimized.num_iterations() == Generic.num_iterations() ? 1e-8 : 1e-4;
+    const CPUAlgebra::vector_type &uOptimized = *Optimized.solution_function();
+    const CPUAlgebra::vector_type &uGeneric = *Generic.solution_function();
+    ASSERT_EQ(uOptimized.size(), uGeneric.size());
+    for (size_t i = 0; i < uOptimized.size(); i++)
+        ASSERT_NEAR(uOptimized[i], uGeneric[i], tolerance) << "at " << i;
+
+    // setup and application per level: P1 optimization on and off, assembled matrices
+    const char *names[] = {"P1 optimization", "generic", "assembled"};
+    const bool p1Optimization[] = {true, false, true};
+    const bool assembled[] = {false, false, true};
+    std::vector<std::vector<TransferTimings>> timings(3);
+    std::vector<std::vector<std::vector<number>>> prolongated(3), restricted(3);
+    for (int v = 0; v < 3; v++)
+        timings[v] = BenchmarkTransfer<Domain3d, CPUAlgebra>(Optimized.approximation_space(), p1Optimization[v], assembled[v], 20,
+                                                            prolongated[v], restricted[v]);
+
+    for (size_t l = 0; l < timings[0].size(); l++)
+    {
+        std::cout << "level " << timings[0][l].level << " (" << timings[0][l].fineDoFs << " DoFs)" << std::endl;
+        for (int v = 0; v < 3; v++)
+            std::cout << "  " << std::setw(16) << std::left << names[v] << std::right << "setup " << timings[v][l].setupSeconds
+                      << " s, prolongate " << timings[v][l].prolongateSeconds << " s, restrict " << timings[v][l].restrictSeconds << " s" << std::endl;
+
+        // all variants have to compute the same transfer
+        for (int v = 1; v < 3; v++)
+        {
+            ASSERT_EQ(prolongated[0][l].size(), prolongated[v][l].size());
+            for (size_t i = 0; i < prolongated[0][l].size(); i++)
+                ASSERT_NEAR(prolongated[0][l][i], prolongated[v][l][i], 1e-12) << names[v] << ", prolongation at " << i;
+            ASSERT_EQ(restricted[0][l].size(), restricted[v][l].size());
+            for (size_t i = 0; i < restricted[0][l].size(); i++)
+                ASSERT_NEAR(restricted[0][l][i], restricted[v][l][i], 1e-12) << names[v] << ", restriction at " << i;
+        }
+    }
+}
+
+TEST(Smoother, SolverBenchmark)
+{
+    #ifdef UG_PARALLEL
+		pcl::Init(nullptr, nullptr);
+	#endif
+
+    typedef CPUAlgebra::vector_type vector_type;
+    typedef std::chrono::steady_clock clock;
+
+    std::string grid = "../plugins/UG4Tests/regression_tests/grids/laplace_sphere_3d.ugx";
+    std::string reference = "../plugins/UG4Tests/regression_tests/references/laplace.txt";
+    Laplace<3> Standard(grid, reference);
+    Standard.run();
+
+    // the fused Jacobi smoother in the GMG has to reproduce the Laplace result
+    GMGSettings settings;
+    settings.smoother = "fused-jacobi";
+    Laplace<3> Fused(grid, reference);
+    Fused.set_gmg_settings(settings);
+    Fused.run();
+
+    // up to rounding, which may move the stopping criterion by an iteration
+    EXPECT_TRUE(Fused.check_residual());
+    EXPECT_LE(std::abs(Standard.num_iterations() - Fused.num_iterations()), 1);
+    const double tolerance = Standard.num_iterations() == Fused.num_iterations() ? 1e-8 : 1e-4;
+    const vector_type &uStandard = *Standard.solution_function();
+    const vector_type &uFused = *Fused.solution_function();
+    ASSERT_EQ(uStandard.size(), uFused.size());
+    for (size_t i = 0; i < uStandard.size(); i++)
+        ASSERT_NEAR(uStandard[i], uFused[i], tolerance) << "at " << i;
+
+    // isolated smoother sweeps on the level matrices of the refined sphere
+    Snapshot snap;
+    Standard.build_snapshot(snap);
+    const std::vector<std::string> smoothers = {"jacobi", "fused-jacobi", "gs", "sgs", "ilu"};
+    const int numSweeps = 20;
+
+    for (size_t lev = 1; lev < snap.levelMatrices.size(); lev++)
+    {
+        SmartPtr<Snapshot::TOperator> A = snap.levelMatrices[lev];
+        const size_t n = A->num_rows();
+        std::cout << "level " << lev << " (" << n << " DoFs)" << std::endl;
+
+        vector_type d0(n), d(n), c(n);
+        for (size_t i = 0; i < n; i++)
+            d0[i] = std::sin(0.1 * i);
+
+        vector_type dJacobi(n);
+        for (const std::string &name : smoothers)
+        {
+            GMGSettings smootherSettings;
+            smootherSettings.smoother = name;
+            SmartPtr<ILinearIterator<vector_type>> smoother = CreateSmoother<CPUAlgebra>(smootherSettings);
+
+            clock::time_point start = clock::now();
+            ASSERT_TRUE(smoother->init(A));
+            const std::chrono::duration<double> setup = clock::now() - start;
+
+            VecScaleAssign(d, 1.0, d0);
+            start = clock::now();
+            for (int sweep = 0; sweep < numSweeps; sweep++)
+                ASSERT_TRUE(smoother->apply_update_defect(c, d));
+            const std::chrono::duration<double> sweeps = clock::now() - start;
+
+            std::cout << "  " << std::setw(14) << std::left << name << std::right << "setup " << setup.count()
+                      << " s, sweep " << sweeps.count() / numSweeps << " s" << std::endl;
+
+            if (name == "jacobi")
+                VecScaleAssign(dJacobi, 1.0, d);
+            if (name == "fused-jacobi")
+                for (size_t i = 0; i < n; i++)
+                    ASSERT_NEAR(dJacobi[i], d[i], 1e-10) << "at " << i;
+        }
+
+        // complete smoothing step of the multigrid: 3 Jacobi steps on A x = b
+        FusedJacobi<CPUAlgebra> Jacobi3(0.66);
+        Jacobi3.init(A);
+        vector_type x(n);
+        x.set(0.0);
+        clock::time_point start = clock::now();
+        Jacobi3.smooth(x, d0, 3);
+        const std::chrono::duration<double> fusedSteps = clock::now() - start;
+        std::cout << "  3 fused steps " << fusedSteps.count() << " s" << std::endl;
+
+        // same iterate as 3 steps in correction form
+        VecScaleAssign(d, 1.0, d0);
+        vector_type xRef(n);
+        xRef.set(0.0);
+        for (int step = 0; step < 3; step++)
+        {
+            Jacobi3.apply_update_defect(c, d);
+            xRef += c;
+        }
+        for (size_t i = 0; i < n; i++)
+            ASSERT_NEAR(xRef[i], x[i], 1e-10) << "at " << i;
+    }
+}
+
+TEST(LaplaceChebyshev, RegressionTests)
+{
+    #ifdef UG_PARALLEL
+		pcl::Init(nullptr, nullptr);
+	#endif
+
+    std::string grid = "../plugins/UG4Tests/regression_tests/grids/laplace_sphere_3d.ugx";
+    std::string reference = "../plugins/UG4Tests/regression_tests/references/laplace.txt";
+    Laplace<3> Jacobi3(grid, reference);
+    Jacobi3.run();
+
+    // equal budget: one Chebyshev application of degree 3 against 3 Jacobi steps
+    GMGSettings settings;
+    settings.smoother = "chebyshev";
+    settings.chebyshevDegree = 3;
+    settings.numPreSmooth = 1;
+    settings.numPostSmooth = 1;
+    Laplace<3> Chebyshev(grid, reference);
+    Chebyshev.set_gmg_settings(settings);
+    Chebyshev.run();
+
+    // another smoother stops at another iterate, so the solution is checked against the
+    // Jacobi run at the solver tolerance, not the reference
+    EXPECT_TRUE(Chebyshev.check_residual());
+    const CPUAlgebra::vector_type &uJacobi = *Jacobi3.solution_function();
+    const CPUAlgebra::vector_type &uChebyshev = *Chebyshev.solution_function();
+    ASSERT_EQ(uJacobi.size(), uChebyshev.size());
+    for (size_t i = 0; i < uJacobi.size(); i++)
+        ASSERT_NEAR(uJacobi[i], uChebyshev[i], 1e-4) << "at " << i;
+
+    // budgets of 1 to 4 matrix-vector products per pre- and post-smoothing
+    std::cout << "smoothing budget  Jacobi                    Chebyshev" << std::endl;
+    for (int budget = 1; budget <= 4; budget++)
+    {
+        GMGSettings jacobi;
+        jacobi.numPreSmooth = budget;
+        jacobi.numPostSmooth = budget;
+        const SolveStatistics jacobiStats = Jacobi3.solve(jacobi);
+
+        GMGSettings chebyshev = settings;
+        chebyshev.chebyshevDegree = budget;
+        const SolveStatistics chebyshevStats = Jacobi3.solve(chebyshev);
+
+        std::cout << "  " << budget << "               " << jacobiStats.iterations << " iterations, " << jacobiStats.seconds
+                  << " s   " << chebyshevStats.iterations << " iterations, " << chebyshevStats.seconds << " s" << std::endl;
+        EXPECT_TRUE(chebyshevStats.converged) << "degree " << budget;
+    }
+}
+
+TEST(DirichletSweep, RegressionTests)
+{
+    #ifdef UG_PARALLEL
+		pcl::Init(nullptr, nullptr);
+	#endif
+
+    std::string grid = "../plugins/UG4Tests/regression_tests/grids/laplace_sphere_3d.ugx";
+    std::string reference = "../plugins/UG4Tests/regression_tests/references/dirichlet_sweep.bin";
+    DirichletSweep<3> Plain(grid, reference);
+    Plain.run();
+
+    DirichletSweep<3> Recycled(grid, reference);
+    Recycled.set_recycling(20);
+    Recycled.run();
+
+    std::cout << "solve  plain  recycled" << std::endl;
+    for (size_t k = 0; k < Plain.iterations().size(); k++)
+        std::cout << std::setw(5) << k << std::setw(7) << Plain.iterations()[k] << std::setw(10) << Recycled.iterations()[k] << std::endl;
+    std::cout << "total" << std::setw(7) << Plain.total_iterations() << std::setw(10) << Recycled.total_iterations() << std::endl;
+    std::cout << "solve time " << Plain.timings().at("solve") << " s plain, " << Recycled.timings().at("solve") << " s recycled" << std::endl;
+
+    EXPECT_LT(Recycled.total_iterations(), Plain.total_iterations());
+    EXPECT_TRUE(Plain.check_residual());
+    EXPECT_TRUE(Recycled.check_residual());
+
+    const std::vector<double> &uPlain = Plain.solution();
+    const std::vector<double> &uRecycled = Recycled.solution();
+    ASSERT_EQ(uPlain.size(), uRecycled.size());
+    for (size_t i = 0; i < uPlain.size(); i++)
+        ASSERT_NEAR(uPlain[i], uRecycled[i], 1e-6) << "at " << i;
+
+    EXPECT_TRUE(Recycled.compare());
+}
+
+TEST(LaplaceSolve, SolverBenchmark)
+{
+    #ifdef UG_PARALLEL
+		pcl::Init(nullptr, nullptr);
+	#endif
+
+    std::string grid = "../plugins/UG4Tests/regression_tests/grids/laplace_sphere_3d.ugx";
+    std::string reference = "../plugins/UG4Tests/regression_tests/references/laplace.txt";
+    Laplace<3> Testcase(grid, reference);
+    Testcase.run();
+
+    // GMG setup and BiCGStab solve of the assembled system, repeated with --benchmark
+    BenchmarkRunner Runner;
+    const BenchmarkResult result = Runner.run("Laplace solve", [&Testcase]()
+                                              {
+                                                  const SolveStatistics stats = Testcase.solve(GMGSettings());
+                                                  EXPECT_TRUE(stats.converged);
+                                                  return stats.seconds; });
+
+    EXPECT_GT(result.median, 0.0);
+    EXPECT_LE(result.ciLower, result.median);
+    EXPECT_GE(result.ciUpper, result.median);
+}
+
+TEST(LaplaceEnergy, SolverBenchmark)
+{
+    #ifdef UG_PARALLEL
+		pcl::Init(nullptr, nullptr);
+	#endif
+
+    const RaplCounters &counters = GlobalRaplCounters();
+    if (!counters.available())
+        GTEST_SKIP() << counters.unavailable_reason();
+
+    std::string grid = "../plugins/UG4Tests/regression_tests/grids/laplace_sphere_3d.ugx";
+    std::string reference = "../plugins/UG4Tests/regression_tests/references/laplace.txt";
+    Laplace<3> laplace(grid, reference);
+    laplace.run();
+
+    // energy to solution of setup and solve for the smoothers of the multigrid
+    const std::vector<std::string> smoothers = {"jacobi", "gs", "sgs", "ilu", "chebyshev"};
+    std::cout << "smoother    iterations  time [s]    energy [J]  power [W]   energy per DoF [J]" << std::endl;
+    for (const std::string &smoother : smoothers)
+    {
+        GMGSettings settings;
+        settings.smoother = smoother;
+        const SolveStatistics stats = laplace.solve(settings);
+        EXPECT_TRUE(stats.converged) << smoother;
+        EXPECT_GE(stats.joules, 0.0) << smoother;
+
+        std::cout << std::left << std::setw(12) << smoother << std::setw(12) << stats.iterations << std::setw(12) << stats.seconds
+                  << std::setw(12) << stats.joules << std::setw(12) << stats.joules / stats.seconds
+                  << stats.joules / stats.numDoFs << std::right << std::endl;
+    }
+}
+
 } // namespace RegressionTest
 } // namespace ug
\ No newline at end of file
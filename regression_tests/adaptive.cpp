@@ -0,0 +1,357 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#include <array>
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ug.h"
+#include "ugbase.h"
+#include "lib_grid/refinement/hanging_node_refiner_multi_grid.h"
+#include "lib_disc/function_spaces/error_elem_marking_strategy.h"
+#include "lib_disc/spatial_disc/elem_disc/err_est_data.h"
+#include "lib_disc/spatial_disc/constraints/continuity_constraints/p1_continuity_constraints.h"
+#include "../../ConvectionDiffusion/convection_diffusion_base.h"
+#include "../../ConvectionDiffusion/fv1/convection_diffusion_fv1.h"
+
+#include "testcase.h"
+#include "solver_setup.h"
+#include "convergence_history.h"
+
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Adaptive refinement testcase
+         *
+         * Solves the Laplace problem on a moderately refined sphere and then refines
+         * adaptively with a hanging node refiner. The elements are marked by the residual
+         * a posteriori error estimator of the FV1 convection-diffusion discretization,
+         * element residuals and jumps of the normal fluxes over the sides, with maximum
+         * marking, which concentrates the refinement at the interface of bndPositive and
+         * bndNegative. For every adaption cycle the number of DoFs and the time spent in
+         * solving, estimating, marking and refining (including the redistribution of the
+         * DoFs) are recorded in the phases "solve", "estimate", "mark" and "refine". The
+         * final solution is compared vertex by vertex with the solution on the globally
+         * refined grid of the same finest level.
+         *
+         * \tparam dim Dimension of the problem
+         */
+        template <int dim>
+        class Adaptive : public Testcase<dim>
+        {
+            typedef Testcase<dim> base_type;
+            typedef typename base_type::TAlgebra TAlgebra;
+            typedef typename base_type::vector_type vector_type;
+            typedef typename base_type::TDomain TDomain;
+            typedef typename base_type::TApproxSpace TApproxSpace;
+            typedef typename base_type::TDirichletBoundary TDirichletBoundary;
+            typedef typename base_type::TDomainDiscretization TDomainDiscretization;
+            typedef typename base_type::TGridFunction TGridFunction;
+            typedef ug::ConvectionDiffusionPlugin::ConvectionDiffusionFV1<TDomain> TConvDiff;
+            typedef ug::AssembledMultiGridCycle<TDomain, TAlgebra> GMG;
+            typedef std::array<long long, dim> TPositionKey;
+
+        public:
+            /**
+             * \brief Statistics of a single adaption cycle
+             */
+            struct Cycle
+            {
+                size_t numDoFs;
+                int iterations;
+                double solveSeconds;
+                double estimateSeconds;
+                double markSeconds;
+                double refineSeconds;
+            };
+
+            /**
+             * Constructor
+             *
+             * \param[in]    grid        Name of the grid file
+             * \param[in]    reference   Name of the reference file
+             */
+            Adaptive(std::string grid, std::string reference)
+                : base_type(grid, reference), m_numAdaptions(3), m_refineFrac(0.1), m_maxError(0.0), m_globalDoFs(0)
+            {
+                this->m_numRefs = 2;
+            }
+
+            /**
+             * \param[in]    numAdaptions    number of adaptive refinements after the global ones
+             * \param[in]    refineFrac      fraction of the largest element error above which elements are refined
+             */
+            void set_adaption(int numAdaptions, number refineFrac)
+            {
+                m_numAdaptions = numAdaptions;
+                m_refineFrac = refineFrac;
+            }
+
+            /**
+             * Runs the adaptive testcase
+             */
+            void run()
+            {
+                AlgebraType algebra("CPU", 1);
+                ug::bridge::InitUG(dim, algebra);
+
+                // Globally refined comparison solution
+                std::map<TPositionKey, number> globalValues;
+                {
+                    SmartPtr<TDomain> domain = make_sp(new TDomain());
+                    LoadDomain(*domain, this->m_gridname.c_str());
+                    GlobalMultiGridRefiner ref(*domain->grid(), domain->refinement_projector());
+                    for (int i = 0; i < this->m_numRefs + m_numAdaptions; i++)
+                        ref.refine();
+
+                    SmartPtr<TApproxSpace> approxSpace = create_approximation_space(domain);
+                    SmartPtr<TDomainDiscretization> domainDisc = create_domain_discretization(approxSpace);
+                    int iterations;
+                    this->start_phase("global solve");
+                    SmartPtr<TGridFunction> u = solve(approxSpace, domainDisc, iterations);
+                    this->stop_phase("global solve");
+                    m_globalDoFs = u->size();
+                    vertex_values(*u, globalValues);
+                }
+
+                // Domain
+                this->m_spDomain = make_sp(new TDomain());
+                LoadDomain(*this->m_spDomain, this->m_gridname.c_str());
+                this->refine(this->m_numRefs);
+                this->m_spApproxSpace = create_approximation_space(this->m_spDomain);
+
+                // Adaption Loop
+                HangingNodeRefiner_MultiGrid refiner(*this->m_spDomain->grid(), this->m_spDomain->refinement_projector());
+                SmartPtr<MaximumMarking<TDomain>> marking = make_sp(new MaximumMarking<TDomain>(m_refineFrac));
+                m_cycles.clear();
+
+                SmartPtr<TGridFunction> u;
+                for (int cycle = 0; cycle <= m_numAdaptions; cycle++)
+                {
+                    Cycle stats;
+                    SmartPtr<TDomainDiscretization> domainDisc = create_domain_discretization(this->m_spApproxSpace);
+
+                    double seconds = phase_seconds("solve");
+                    this->start_phase("solve");
+                    u = solve(this->m_spApproxSpace, domainDisc, stats.iterations);
+                    this->stop_phase("solve");
+                    stats.solveSeconds = phase_seconds("solve") - seconds;
+                    stats.numDoFs = u->size();
+                    stats.estimateSeconds = 0.0;
+                    stats.markSeconds = 0.0;
+                    stats.refineSeconds = 0.0;
+
+                    if (cycle < m_numAdaptions)
+                    {
+                        seconds = phase_seconds("estimate");
+                        this->start_phase("estimate");
+                        domainDisc->calc_error(*u);
+                        this->stop_phase("estimate");
+                        stats.estimateSeconds = phase_seconds("estimate") - seconds;
+
+                        seconds = phase_seconds("mark");
+                        this->start_phase("mark");
+                        domainDisc->mark_with_strategy(refiner, marking);
+                        this->stop_phase("mark");
+                        stats.markSeconds = phase_seconds("mark") - seconds;
+
+                        seconds = phase_seconds("refine");
+                        this->start_phase("refine");
+                        refiner.refine();
+                        this->stop_phase("refine");
+                        stats.refineSeconds = phase_seconds("refine") - seconds;
+                    }
+
+                    m_cycles.push_back(stats);
+                }
+
+                // Error against the globally refined solution
+                std::map<TPositionKey, number> adaptiveValues;
+                vertex_values(*u, adaptiveValues);
+
+                m_maxError = 0.0;
+                for (typename std::map<TPositionKey, number>::const_iterator it = adaptiveValues.begin(); it != adaptiveValues.end(); ++it)
+                {
+                    typename std::map<TPositionKey, number>::const_iterator global = globalValues.find(it->first);
+                    if (global == globalValues.end())
+                        UG_THROW("Adaptive: vertex of the adaptive grid not found in the globally refined grid.");
+                    m_maxError = std::max(m_maxError, std::abs(it->second - global->second));
+                }
+
+                // Save Solution
+                this->store_solution(*u);
+            }
+
+            /**
+             * \return statistics of all adaption cycles
+             */
+            const std::vector<Cycle> &cycles() const
+            {
+                return m_cycles;
+            }
+
+            /**
+             * \return maximum nodal difference between the final adaptive and the globally refined solution
+             */
+            number max_error() const
+            {
+                return m_maxError;
+            }
+
+            /**
+             * \return number of DoFs of the globally refined solution
+             */
+            size_t global_dofs() const
+            {
+                return m_globalDoFs;
+            }
+
+        protected:
+            /**
+             * \param[in]    domain  domain of the problem
+             * \return P1 approximation space on the domain
+             */
+            SmartPtr<TApproxSpace> create_approximation_space(SmartPtr<TDomain> domain)
+            {
+                SmartPtr<TApproxSpace> approxSpace = make_sp(new TApproxSpace(domain));
+                approxSpace->add("c", "Lagrange", 1);
+                approxSpace->init_levels();
+                approxSpace->init_top_surface();
+                return approxSpace;
+            }
+
+            /**
+             * \param[in]    approxSpace     approximation space
+             * \return discretization of the Laplace problem with hanging node constraints and
+             *         the residual error estimator
+             */
+            SmartPtr<TDomainDiscretization> create_domain_discretization(SmartPtr<TApproxSpace> approxSpace)
+            {
+                // Element Discretization with residual error estimator
+                SmartPtr<TConvDiff> cd = make_sp(new TConvDiff("c", "Inner"));
+                cd->set_diffusion(1.0);
+                cd->set_reaction(0.0);
+                cd->set_error_estimator(make_sp(new SideAndElemErrEstData<TDomain>(2, 2, "Inner")));
+
+                // Dirichlet Boundary Conditions
+                SmartPtr<TDirichletBoundary> boundary = make_sp(new TDirichletBoundary());
+                boundary->add(-1, "c", "bndNegative");
+                boundary->add(1, "c", "bndPositive");
+
+                // Domain Discretization with hanging node constraints
+                SmartPtr<TDomainDiscretization> domainDisc = make_sp(new TDomainDiscretization(approxSpace));
+                domainDisc->add(cd);
+                domainDisc->add(boundary);
+                domainDisc->add(make_sp(new SymP1Constraints<TDomain, TAlgebra>()));
+                return domainDisc;
+            }
+
+            /**
+             * Assembles and solves the Laplace problem on the surface of the approximation space
+             *
+             * \param[in]    approxSpace     approximation space
+             * \param[in]    domainDisc      domain discretization on the approximation space
+             * \param[out]   iterations      number of BiCGStab iterations
+             * \return the solution
+             */
+            SmartPtr<TGridFunction> solve(SmartPtr<TApproxSpace> approxSpace, SmartPtr<TDomainDiscretization> domainDisc, int &iterations)
+            {
+                // BiCGStab with GMG
+                SmartPtr<GMG> gmg = CreateGMG<TDomain, TAlgebra>(approxSpace);
+                SmartPtr<TracedConvCheck<vector_type>> convCheck = make_sp(new TracedConvCheck<vector_type>(100, 1e-12, 1e-6, false));
+                BiCGStab<vector_type> solver;
+                solver.set_preconditioner(gmg);
+                solver.set_convergence_check(convCheck);
+
+                // Assemble and Solve
+                SmartPtr<AssembledLinearOperator<TAlgebra>> op = make_sp(new AssembledLinearOperator<TAlgebra>(domainDisc));
+                SmartPtr<TGridFunction> u = make_sp(new TGridFunction(approxSpace));
+                SmartPtr<TGridFunction> b = make_sp(new TGridFunction(approxSpace));
+
+                u->set(0.0);
+                domainDisc->adjust_solution(*u);
+                domainDisc->assemble_linear(*op, *b);
+
+                if (!solver.init(op, *u) || !solver.apply(*u, *b))
+                    UG_THROW("Adaptive: BiCGStab did not converge.");
+
+                iterations = convCheck->step();
+                return u;
+            }
+
+            /**
+             * collects the values of all surface vertices, keyed by their rounded position
+             *
+             * \param[in]    u       solution
+             * \param[out]   values  values per vertex position
+             */
+            void vertex_values(const TGridFunction &u, std::map<TPositionKey, number> &values) const
+            {
+                typedef typename TGridFunction::template traits<Vertex>::const_iterator TIterator;
+                const typename TDomain::position_accessor_type &aaPos = u.domain()->position_accessor();
+
+                std::vector<DoFIndex> ind;
+                for (TIterator it = u.template begin<Vertex>(); it != u.template end<Vertex>(); ++it)
+                {
+                    TPositionKey key;
+                    for (int d = 0; d < dim; d++)
+                        key[d] = std::llround(aaPos[*it][d] * 1e9);
+
+                    u.inner_dof_indices(*it, 0, ind);
+                    values[key] = DoFRef(u, ind[0]);
+                }
+            }
+
+            /**
+             * \param[in]    phase   name of the phase
+             * \return seconds accumulated in the phase so far
+             */
+            double phase_seconds(const std::string &phase) const
+            {
+                std::map<std::string, double>::const_iterator it = this->m_timings.find(phase);
+                return it == this->m_timings.end() ? 0.0 : it->second;
+            }
+
+            std::vector<Cycle> m_cycles;
+            int m_numAdaptions;
+            number m_refineFrac;
+            number m_maxError;
+            size_t m_globalDoFs;
+        };
+
+    } // namespace RegressionTest
+} // namespace ug
@@ -0,0 +1,451 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef UG4TESTS_REGRESSION_TESTS_BENCHMARK_HISTORY_H
+#define UG4TESTS_REGRESSION_TESTS_BENCHMARK_HISTORY_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __unix__
+#include <unistd.h>
+#endif
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief One measurement in the benchmark history
+         *
+         * The history is a single tab separated file with one record per line, appended
+         * by every run of ug4tests with --history=<file>. Records are keyed by the build
+         * (git hash, compiler, flags) and the machine, so that only comparable
+         * measurements end up in the same time series.
+         */
+        struct HistoryRecord
+        {
+            HistoryRecord() : time(0), value(0.0) {}
+
+            /// seconds since the epoch
+            long long time;
+            std::string gitHash;
+            std::string compiler;
+            std::string flags;
+            std::string machine;
+            /// googletest name of the test, e.g. Laplace.SmokeTests
+            std::string test;
+            /// measured quantity, e.g. "phase/solve" or "benchmark/GMG V-cycle"
+            std::string metric;
+            /// measured value in seconds
+            double value;
+
+            /**
+             * \return key of the time series the record belongs to
+             */
+            std::string series() const
+            {
+                return test + "\t" + metric + "\t" + compiler + "\t" + flags + "\t" + machine;
+            }
+        };
+
+        /// header line of the history file
+        const char *const HistoryHeader = "# time\tgit\tcompiler\tflags\tmachine\ttest\tmetric\tvalue";
+
+        /**
+         * \return the string with tabs and line breaks replaced by blanks
+         */
+        inline std::string SanitizeHistoryField(std::string field)
+        {
+            std::replace(field.begin(), field.end(), '\t', ' ');
+            std::replace(field.begin(), field.end(), '\n', ' ');
+            std::replace(field.begin(), field.end(), '\r', ' ');
+            return field.empty() ? "-" : field;
+        }
+
+        /**
+         * \return git hash of the sources the binary was configured from
+         */
+        inline std::string BuildGitHash()
+        {
+#ifdef UG4TESTS_GIT_HASH
+            const std::string hash = UG4TESTS_GIT_HASH;
+            return hash.empty() ? "unknown" : hash;
+#else
+            return "unknown";
+#endif
+        }
+
+        /**
+         * \return name and version of the compiler the binary was built with
+         */
+        inline std::string BuildCompiler()
+        {
+#if defined(__clang__)
+            return std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+            return std::string("gcc ") + __VERSION__;
+#else
+            return "unknown";
+#endif
+        }
+
+        /**
+         * \return build type and compiler flags the binary was built with
+         */
+        inline std::string BuildFlags()
+        {
+#ifdef UG4TESTS_CXX_FLAGS
+            return UG4TESTS_CXX_FLAGS;
+#else
+            return "unknown";
+#endif
+        }
+
+        /**
+         * \return host name, CPU model and number of hardware threads of the machine
+         */
+        inline std::string MachineFingerprint()
+        {
+            std::string host = "unknown";
+#ifdef __unix__
+            char name[256];
+            if (gethostname(name, sizeof(name)) == 0)
+            {
+                name[sizeof(name) - 1] = '\0';
+                host = name;
+            }
+#endif
+            std::string model = "unknown";
+            std::ifstream cpuinfo("/proc/cpuinfo");
+            std::string line;
+            while (std::getline(cpuinfo, line))
+            {
+                if (line.compare(0, 10, "model name") == 0 && line.find(':') != std::string::npos)
+                {
+                    model = line.substr(line.find(':') + 1);
+                    model.erase(0, model.find_first_not_of(' '));
+                    break;
+                }
+            }
+            std::ostringstream ss;
+            ss << host << " / " << model << " / " << std::thread::hardware_concurrency() << " threads";
+            return ss.str();
+        }
+
+        /**
+         * writes a record as one line of the history file
+         */
+        inline void WriteHistoryRecord(std::ostream &out, const HistoryRecord &record)
+        {
+            std::ostringstream value;
+            value.precision(9);
+            value << record.value;
+            out << record.time << "\t" << SanitizeHistoryField(record.gitHash) << "\t" << SanitizeHistoryField(record.compiler) << "\t"
+                << SanitizeHistoryField(record.flags) << "\t" << SanitizeHistoryField(record.machine) << "\t"
+                << SanitizeHistoryField(record.test) << "\t" << SanitizeHistoryField(record.metric) << "\t" << value.str() << "\n";
+        }
+
+        /**
+         * parses a line of the history file
+         *
+         * \return false for comments and malformed lines
+         */
+        inline bool ParseHistoryRecord(const std::string &line, HistoryRecord &record)
+        {
+            if (line.empty() || line[0] == '#')
+                return false;
+
+            std::vector<std::string> fields;
+            std::istringstream ss(line);
+            std::string field;
+            while (std::getline(ss, field, '\t'))
+                fields.push_back(field);
+            if (fields.size() != 8)
+                return false;
+
+            char *end;
+            record.time = std::strtoll(fields[0].c_str(), &end, 10);
+            if (*end != '\0')
+                return false;
+            record.gitHash = fields[1];
+            record.compiler = fields[2];
+            record.flags = fields[3];
+            record.machine = fields[4];
+            record.test = fields[5];
+            record.metric = fields[6];
+            record.value = std::strtod(fields[7].c_str(), &end);
+            return *end == '\0';
+        }
+
+        /**
+         * appends records to the history file, writing the header to a new file
+         *
+         * \return false if the file could not be written
+         */
+        inline bool AppendHistory(const std::string &filename, const std::vector<HistoryRecord> &records)
+        {
+            const bool exists = std::ifstream(filename).good();
+            std::ofstream out(filename, std::ios::app);
+            if (!out)
+                return false;
+            if (!exists)
+                out << HistoryHeader << "\n";
+            for (const HistoryRecord &record : records)
+                WriteHistoryRecord(out, record);
+            return out.good();
+        }
+
+        /**
+         * \return all records of the history file in the order they were appended
+         */
+        inline std::vector<HistoryRecord> ReadHistory(const std::string &filename)
+        {
+            std::vector<HistoryRecord> records;
+            std::ifstream in(filename);
+            std::string line;
+            HistoryRecord record;
+            while (std::getline(in, line))
+                if (ParseHistoryRecord(line, record))
+                    records.push_back(record);
+            return records;
+        }
+
+        /**
+         * \brief Step change in a time series of measurements
+         */
+        struct ChangePoint
+        {
+            /// index of the first measurement after the change
+            size_t index;
+            /// relative change of the geometric mean, 0.05 is 5% slower
+            double shift;
+            /// Welch t statistic of the change, in log space
+            double tStatistic;
+        };
+
+        /**
+         * \brief Gradual drift of a time series, fitted between its change points
+         */
+        struct Drift
+        {
+            Drift() : perMonth(0.0), tStatistic(0.0) {}
+
+            /// relative change per 30 days, 0.02 is 2% slower per month
+            double perMonth;
+            /// t statistic of the slope
+            double tStatistic;
+        };
+
+        /**
+         * \brief Thresholds of the trend analysis
+         */
+        struct TrendOptions
+        {
+            TrendOptions() : minShift(0.03), minDrift(0.01), threshold(5.0), minSegment(3) {}
+
+            /// smallest relative step reported as change point
+            double minShift;
+            /// smallest relative drift per month reported
+            double minDrift;
+            /// t statistic above which a change point or drift is significant
+            double threshold;
+            /// minimum number of measurements on each side of a change point
+            size_t minSegment;
+        };
+
+        /**
+         * \brief Result of the trend analysis of one time series
+         */
+        struct TrendAnalysis
+        {
+            std::vector<ChangePoint> changePoints;
+            Drift drift;
+            bool driftSignificant;
+        };
+
+        /**
+         * \brief Least squares fit of a line
+         *
+         * \return residual sum of squares of the fit of y[begin, end) over x[begin, end)
+         */
+        inline double LinearFit(const std::vector<double> &x, const std::vector<double> &y, size_t begin, size_t end,
+                                double &slope, double &sxx)
+        {
+            const double n = end - begin;
+            double mx = 0.0, my = 0.0;
+            for (size_t i = begin; i < end; i++)
+            {
+                mx += x[i];
+                my += y[i];
+            }
+            mx /= n;
+            my /= n;
+
+            double sxy = 0.0, syy = 0.0;
+            sxx = 0.0;
+            for (size_t i = begin; i < end; i++)
+            {
+                sxx += (x[i] - mx) * (x[i] - mx);
+                sxy += (x[i] - mx) * (y[i] - my);
+                syy += (y[i] - my) * (y[i] - my);
+            }
+            slope = sxx > 0.0 ? sxy / sxx : 0.0;
+            return std::max(0.0, syy - slope * sxy);
+        }
+
+        /**
+         * \return mean and sum of squared deviations of y[begin, end)
+         */
+        inline double SegmentMean(const std::vector<double> &y, size_t begin, size_t end, double &ss)
+        {
+            double mean = 0.0;
+            for (size_t i = begin; i < end; i++)
+                mean += y[i];
+            mean /= (end - begin);
+            ss = 0.0;
+            for (size_t i = begin; i < end; i++)
+                ss += (y[i] - mean) * (y[i] - mean);
+            return mean;
+        }
+
+        /**
+         * \brief Binary segmentation of y[begin, end) into segments of constant mean
+         *
+         * Each segment is split at the position with the largest Welch t statistic,
+         * as long as the step is significant, larger than minShift and explains the
+         * segment better than a straight line, so that a gradual drift is not cut into
+         * a staircase of change points.
+         */
+        inline void FindChangePoints(const std::vector<double> &x, const std::vector<double> &y, size_t begin, size_t end,
+                                     const TrendOptions &options, std::vector<ChangePoint> &changePoints)
+        {
+            if (end - begin < 2 * options.minSegment)
+                return;
+
+            ChangePoint best = {0, 0.0, 0.0};
+            double bestSS = 0.0;
+            for (size_t k = begin + options.minSegment; k + options.minSegment <= end; k++)
+            {
+                double ss1, ss2;
+                const double m1 = SegmentMean(y, begin, k, ss1);
+                const double m2 = SegmentMean(y, k, end, ss2);
+                const double n1 = k - begin, n2 = end - k;
+                const double se = std::sqrt(ss1 / (n1 * std::max(1.0, n1 - 1)) + ss2 / (n2 * std::max(1.0, n2 - 1)));
+                const double t = se > 0.0 ? std::fabs(m2 - m1) / se : (m1 != m2 ? HUGE_VAL : 0.0);
+                if (t > best.tStatistic)
+                {
+                    best.index = k;
+                    best.shift = std::exp(m2 - m1) - 1.0;
+                    best.tStatistic = t;
+                    bestSS = ss1 + ss2;
+                }
+            }
+
+            double slope, sxx;
+            const double lineSS = LinearFit(x, y, begin, end, slope, sxx);
+            if (best.tStatistic < options.threshold || std::fabs(best.shift) < options.minShift || bestSS >= lineSS)
+                return;
+
+            FindChangePoints(x, y, begin, best.index, options, changePoints);
+            changePoints.push_back(best);
+            FindChangePoints(x, y, best.index, end, options, changePoints);
+        }
+
+        /**
+         * \brief Detects change points and gradual drifts in a time series
+         *
+         * The measurements are analyzed in log space, so that shifts and drifts are
+         * relative. The drift is the common slope of all segments between the change
+         * points, with a separate intercept per segment.
+         *
+         * \param[in] times      seconds since the epoch, ascending
+         * \param[in] values     measured values, positive
+         * \param[in] options    thresholds
+         */
+        inline TrendAnalysis AnalyzeTrend(const std::vector<double> &times, const std::vector<double> &values,
+                                          const TrendOptions &options = TrendOptions())
+        {
+            TrendAnalysis analysis;
+            analysis.driftSignificant = false;
+
+            const double month = 30.0 * 24.0 * 3600.0;
+            std::vector<double> x, y;
+            for (size_t i = 0; i < values.size(); i++)
+            {
+                x.push_back(times[i] / month);
+                y.push_back(std::log(std::max(values[i], 1e-300)));
+            }
+
+            FindChangePoints(x, y, 0, y.size(), options, analysis.changePoints);
+
+            std::vector<size_t> bounds(1, 0);
+            for (const ChangePoint &cp : analysis.changePoints)
+                bounds.push_back(cp.index);
+            bounds.push_back(y.size());
+
+            // sums of squares around the segment means
+            double sxx = 0.0, sxy = 0.0, syy = 0.0;
+            for (size_t s = 0; s + 1 < bounds.size(); s++)
+            {
+                double segSlope, segSxx;
+                const double segSS = LinearFit(x, y, bounds[s], bounds[s + 1], segSlope, segSxx);
+                sxx += segSxx;
+                sxy += segSlope * segSxx;
+                syy += segSS + segSlope * segSlope * segSxx;
+            }
+            const double dof = (double)y.size() - (bounds.size() - 1) - 1;
+            if (sxx <= 0.0 || dof < 1.0)
+                return analysis;
+
+            const double slope = sxy / sxx;
+            const double residual = std::max(0.0, syy - slope * sxy);
+            const double se = std::sqrt(residual / dof / sxx);
+            analysis.drift.perMonth = std::exp(slope) - 1.0;
+            analysis.drift.tStatistic = se > 0.0 ? std::fabs(slope) / se : (slope != 0.0 ? HUGE_VAL : 0.0);
+            analysis.driftSignificant = analysis.drift.tStatistic >= options.threshold &&
+                                        std::fabs(analysis.drift.perMonth) >= options.minDrift;
+            return analysis;
+        }
+
+    } // namespace RegressionTest
+} // namespace ug
+
+#endif /* UG4TESTS_REGRESSION_TESTS_BENCHMARK_HISTORY_H */
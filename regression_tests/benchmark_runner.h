@@ -0,0 +1,417 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef UG4TESTS_REGRESSION_TESTS_BENCHMARK_RUNNER_H
+#define UG4TESTS_REGRESSION_TESTS_BENCHMARK_RUNNER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include "phase_observer.h"
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Options of the benchmark mode, set from the command line of ug4tests
+         *
+         * Without --benchmark every measurement is taken once, so tests using the
+         * BenchmarkRunner stay fast in the regular runs.
+         */
+        struct BenchmarkOptions
+        {
+            BenchmarkOptions()
+                : enabled(false), numWarmup(2), minRepetitions(5), maxRepetitions(50), relativeCI(0.02),
+                  outlierThreshold(3.0), pin(true), cpu(-1)
+            {
+            }
+
+            bool enabled;
+            int numWarmup;
+            int minRepetitions;
+            int maxRepetitions;
+            /// target half width of the confidence interval of the median, relative to the median
+            double relativeCI;
+            /// samples further than this many scaled MADs from the median are outliers
+            double outlierThreshold;
+            bool pin;
+            /// core to pin to, -1 for the core the process is running on
+            int cpu;
+        };
+
+        /**
+         * \return the global benchmark options
+         */
+        inline BenchmarkOptions &GlobalBenchmarkOptions()
+        {
+            static BenchmarkOptions options;
+            return options;
+        }
+
+        /**
+         * \brief Parses and removes the benchmark options from the command line
+         *
+         * --benchmark, --benchmark-warmup=N, --benchmark-min-reps=N, --benchmark-max-reps=N,
+         * --benchmark-ci=X, --benchmark-cpu=N and --benchmark-no-pin. Other arguments are
+         * kept for googletest.
+         */
+        inline void ParseBenchmarkOptions(int &argc, char **argv)
+        {
+            BenchmarkOptions &options = GlobalBenchmarkOptions();
+            int kept = 1;
+            for (int i = 1; i < argc; i++)
+            {
+                const std::string arg = argv[i];
+                const std::string value = arg.substr(arg.find('=') + 1);
+                if (arg == "--benchmark")
+                    options.enabled = true;
+                else if (arg.compare(0, 19, "--benchmark-warmup=") == 0)
+                    options.numWarmup = std::atoi(value.c_str());
+                else if (arg.compare(0, 21, "--benchmark-min-reps=") == 0)
+                    options.minRepetitions = std::atoi(value.c_str());
+                else if (arg.compare(0, 21, "--benchmark-max-reps=") == 0)
+                    options.maxRepetitions = std::atoi(value.c_str());
+                else if (arg.compare(0, 15, "--benchmark-ci=") == 0)
+                    options.relativeCI = std::atof(value.c_str());
+                else if (arg.compare(0, 16, "--benchmark-cpu=") == 0)
+                    options.cpu = std::atoi(value.c_str());
+                else if (arg == "--benchmark-no-pin")
+                    options.pin = false;
+                else
+                    argv[kept++] = argv[i];
+            }
+            argc = kept;
+            argv[argc] = nullptr;
+        }
+
+        /**
+         * \return median of the values
+         */
+        inline double Median(std::vector<double> values)
+        {
+            if (values.empty())
+                return 0.0;
+            std::sort(values.begin(), values.end());
+            const size_t n = values.size();
+            return (n % 2) ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+        }
+
+        /**
+         * \return p-th percentile (0 <= p <= 100) of the values, linearly interpolated
+         */
+        inline double Percentile(std::vector<double> values, double p)
+        {
+            if (values.empty())
+                return 0.0;
+            std::sort(values.begin(), values.end());
+            const double pos = p / 100.0 * (values.size() - 1);
+            const size_t lower = (size_t)std::floor(pos);
+            const size_t upper = std::min(lower + 1, values.size() - 1);
+            return values[lower] + (pos - lower) * (values[upper] - values[lower]);
+        }
+
+        /**
+         * Splits the values into inliers and outliers by their distance to the median in
+         * units of the median absolute deviation, scaled to the standard deviation of a
+         * normal distribution
+         *
+         * \param[in]    values      samples
+         * \param[in]    threshold   maximal distance of inliers
+         * \param[out]   inliers     kept samples
+         * \return number of outliers
+         */
+        inline size_t RejectOutliers(const std::vector<double> &values, double threshold, std::vector<double> &inliers)
+        {
+            const double median = Median(values);
+            std::vector<double> deviations;
+            for (double v : values)
+                deviations.push_back(std::fabs(v - median));
+            const double scaledMAD = 1.4826 * Median(deviations);
+
+            inliers.clear();
+            for (double v : values)
+                if (scaledMAD == 0.0 || std::fabs(v - median) <= threshold * scaledMAD)
+                    inliers.push_back(v);
+            return values.size() - inliers.size();
+        }
+
+        /**
+         * Distribution-free 95% confidence interval of the median from order statistics
+         *
+         * \param[in]    values  samples
+         * \param[out]   lower   lower bound
+         * \param[out]   upper   upper bound
+         */
+        inline void MedianConfidenceInterval(std::vector<double> values, double &lower, double &upper)
+        {
+            lower = upper = 0.0;
+            if (values.empty())
+                return;
+            std::sort(values.begin(), values.end());
+            const double n = values.size();
+            const double halfWidth = 1.96 * std::sqrt(n) / 2.0;
+            const long lo = (long)std::floor(n / 2.0 - halfWidth);
+            const long hi = (long)std::ceil(n / 2.0 + halfWidth);
+            lower = values[std::max(0L, lo)];
+            upper = values[std::min((long)values.size() - 1, hi)];
+        }
+
+        /**
+         * \brief Statistics of a benchmark
+         */
+        struct BenchmarkResult
+        {
+            BenchmarkResult() : median(0.0), p95(0.0), ciLower(0.0), ciUpper(0.0), numOutliers(0), converged(false) {}
+
+            /// all measured samples in seconds, without warmup
+            std::vector<double> samples;
+            double median;
+            double p95;
+            double ciLower;
+            double ciUpper;
+            size_t numOutliers;
+            /// confidence interval reached the requested width
+            bool converged;
+            /// notes on the measurement conditions, e.g. frequency scaling
+            std::vector<std::string> warnings;
+
+            double relative_ci() const
+            {
+                return median > 0.0 ? 0.5 * (ciUpper - ciLower) / median : 0.0;
+            }
+        };
+
+        /**
+         * \brief Pins the calling thread to one core and restores its previous affinity
+         * on destruction
+         */
+        class ScopedThreadPinning
+        {
+        public:
+            ScopedThreadPinning() : m_bPinned(false) {}
+
+            ~ScopedThreadPinning()
+            {
+                #ifdef __linux__
+                if (m_bPinned)
+                    sched_setaffinity(0, sizeof(m_saved), &m_saved);
+                #endif
+            }
+
+            /**
+             * \param[in]    cpu     core to pin the calling thread to
+             * \return true if the thread was pinned
+             */
+            bool pin(int cpu)
+            {
+                #ifdef __linux__
+                if (!m_bPinned && sched_getaffinity(0, sizeof(m_saved), &m_saved) != 0)
+                    return false;
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(cpu, &set);
+                if (sched_setaffinity(0, sizeof(set), &set) != 0)
+                    return false;
+                m_bPinned = true;
+                return true;
+                #else
+                return false;
+                #endif
+            }
+
+        private:
+            ScopedThreadPinning(const ScopedThreadPinning &);
+            ScopedThreadPinning &operator=(const ScopedThreadPinning &);
+
+            bool m_bPinned;
+            #ifdef __linux__
+            /// affinity before the first pin()
+            cpu_set_t m_saved;
+            #endif
+        };
+
+        /**
+         * \brief Runs a measurement repeatedly until its median is known precisely
+         *
+         * Performs warmup runs, pins the calling thread to one core for the duration of
+         * run(), repeats the measurement until the confidence interval of the median after
+         * outlier rejection is narrower than requested or the maximum number of
+         * repetitions is reached, and reports median, 95th percentile and confidence interval. CPU frequency scaling
+         * (governor other than "performance", enabled turbo, changing clock during the
+         * measurement) is detected on Linux and reported as warning, since it makes
+         * timings machine-state dependent.
+         */
+        class BenchmarkRunner
+        {
+        public:
+            explicit BenchmarkRunner(const BenchmarkOptions &options = GlobalBenchmarkOptions())
+                : m_options(options)
+            {
+            }
+
+            /**
+             * \param[in]    name    name of the benchmark in the report
+             * \param[in]    sample  performs one measurement and returns its time in seconds
+             * \return statistics of the measurement
+             */
+            BenchmarkResult run(const std::string &name, const std::function<double()> &sample)
+            {
+                BenchmarkResult result;
+                if (!m_options.enabled)
+                {
+                    result.samples.push_back(sample());
+                    result.median = result.p95 = result.ciLower = result.ciUpper = result.samples.back();
+                    NotifyMetric(name, result.median);
+                    return result;
+                }
+
+                ScopedThreadPinning pinning;
+                pin_thread(pinning, result);
+                check_frequency_scaling(result);
+
+                for (int i = 0; i < m_options.numWarmup; i++)
+                    sample();
+
+                const double freqBefore = current_frequency();
+                std::vector<double> inliers;
+                while ((int)result.samples.size() < m_options.maxRepetitions)
+                {
+                    result.samples.push_back(sample());
+                    if ((int)result.samples.size() < m_options.minRepetitions)
+                        continue;
+
+                    result.numOutliers = RejectOutliers(result.samples, m_options.outlierThreshold, inliers);
+                    result.median = Median(inliers);
+                    MedianConfidenceInterval(inliers, result.ciLower, result.ciUpper);
+                    if (result.relative_ci() <= m_options.relativeCI)
+                    {
+                        result.converged = true;
+                        break;
+                    }
+                }
+                result.p95 = Percentile(inliers, 95.0);
+
+                const double freqAfter = current_frequency();
+                if (freqBefore > 0.0 && freqAfter > 0.0 && std::fabs(freqAfter - freqBefore) > 0.05 * freqBefore)
+                {
+                    std::ostringstream ss;
+                    ss << "clock changed from " << freqBefore / 1e3 << " to " << freqAfter / 1e3 << " MHz during the measurement";
+                    result.warnings.push_back(ss.str());
+                }
+
+                report(name, result);
+                NotifyMetric(name, result.median);
+                return result;
+            }
+
+        protected:
+            void report(const std::string &name, const BenchmarkResult &result) const
+            {
+                std::cout << "benchmark " << name << ": median " << result.median << " s, p95 " << result.p95
+                          << " s, 95% CI [" << result.ciLower << ", " << result.ciUpper << "] (+-" << 100.0 * result.relative_ci()
+                          << "%), " << result.samples.size() << " samples, " << result.numOutliers << " outliers";
+                if (!result.converged)
+                    std::cout << ", CI target of " << 100.0 * m_options.relativeCI << "% not reached";
+                std::cout << std::endl;
+                for (const std::string &warning : result.warnings)
+                    std::cout << "  warning: " << warning << std::endl;
+            }
+
+            void pin_thread(ScopedThreadPinning &pinning, BenchmarkResult &result)
+            {
+                m_cpu = -1;
+                if (!m_options.pin)
+                    return;
+                #ifdef __linux__
+                const int cpu = m_options.cpu >= 0 ? m_options.cpu : sched_getcpu();
+                if (pinning.pin(cpu))
+                    m_cpu = cpu;
+                else
+                    result.warnings.push_back("could not pin the thread to core " + std::to_string(cpu));
+                #else
+                result.warnings.push_back("thread pinning is not supported on this platform");
+                #endif
+            }
+
+            /// \return content of a sysfs file of the pinned core, empty if not readable
+            std::string read_cpufreq(const std::string &file) const
+            {
+                std::ifstream in("/sys/devices/system/cpu/cpu" + std::to_string(std::max(m_cpu, 0)) + "/cpufreq/" + file);
+                std::string value;
+                in >> value;
+                return value;
+            }
+
+            /// \return current clock of the pinned core in kHz, 0 if unknown
+            double current_frequency() const
+            {
+                const std::string value = read_cpufreq("scaling_cur_freq");
+                return value.empty() ? 0.0 : std::atof(value.c_str());
+            }
+
+            void check_frequency_scaling(BenchmarkResult &result) const
+            {
+                const std::string governor = read_cpufreq("scaling_governor");
+                if (!governor.empty() && governor != "performance")
+                    result.warnings.push_back("frequency scaling governor is '" + governor + "', not 'performance'");
+
+                std::ifstream noTurbo("/sys/devices/system/cpu/intel_pstate/no_turbo");
+                int value = 1;
+                if (noTurbo >> value && value == 0)
+                    result.warnings.push_back("turbo boost is enabled");
+
+                std::ifstream boost("/sys/devices/system/cpu/cpufreq/boost");
+                if (boost >> value && value == 1)
+                    result.warnings.push_back("frequency boost is enabled");
+            }
+
+            BenchmarkOptions m_options;
+            int m_cpu = -1;
+        };
+
+    } // namespace RegressionTest
+} // namespace ug
+
+#endif /* UG4TESTS_REGRESSION_TESTS_BENCHMARK_RUNNER_H */
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef UG4TESTS_REGRESSION_TESTS_CHEBYSHEV_SMOOTHER_H
+#define UG4TESTS_REGRESSION_TESTS_CHEBYSHEV_SMOOTHER_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "ug.h"
+#include "ugbase.h"
+#include "lib_algebra/operator/interface/linear_iterator.h"
+#include "lib_algebra/operator/interface/matrix_operator.h"
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Jacobi preconditioned Chebyshev polynomial smoother
+         *
+         * Each application performs degree steps of the Chebyshev iteration for D^-1 A on
+         * the interval [lowerFraction * lambdaMax, upperFraction * lambdaMax], so it costs
+         * degree matrix-vector products and no triangular solves. The largest eigenvalue
+         * lambdaMax of D^-1 A is estimated once in init() by power iteration. Serial only;
+         * scalar algebras only.
+         *
+         * \tparam TAlgebra algebra type
+         */
+        template <typename TAlgebra>
+        class ChebyshevSmoother : public ILinearIterator<typename TAlgebra::vector_type>
+        {
+        public:
+            typedef typename TAlgebra::vector_type vector_type;
+            typedef typename TAlgebra::matrix_type matrix_type;
+            typedef ILinearIterator<vector_type> base_type;
+
+            /**
+             * \param[in]    degree          degree of the polynomial, i.e. matrix-vector products per application
+             * \param[in]    lowerFraction   lower end of the smoothing interval relative to lambdaMax
+             * \param[in]    upperFraction   upper end of the smoothing interval relative to lambdaMax
+             * \param[in]    powerSteps      power iteration steps of the eigenvalue estimate
+             */
+            explicit ChebyshevSmoother(int degree = 3, number lowerFraction = 0.1, number upperFraction = 1.1, int powerSteps = 15)
+                : m_degree(degree), m_lowerFraction(lowerFraction), m_upperFraction(upperFraction), m_powerSteps(powerSteps),
+                  m_lambdaMax(0.0)
+            {
+            }
+
+            virtual const char *name() const { return "ChebyshevSmoother"; }
+
+            virtual bool supports_parallel() const { return false; }
+
+            virtual bool init(SmartPtr<ILinearOperator<vector_type>> J, const vector_type &u)
+            {
+                return init(J);
+            }
+
+            virtual bool init(SmartPtr<ILinearOperator<vector_type>> L)
+            {
+                m_spOp = L.template cast_dynamic<MatrixOperator<matrix_type, vector_type>>();
+                if (m_spOp.invalid())
+                    UG_THROW("ChebyshevSmoother: operator is not a matrix.");
+
+                const matrix_type &A = m_spOp->get_matrix();
+                const size_t n = A.num_rows();
+                m_invDiag.assign(n, 0.0);
+                for (size_t i = 0; i < n; i++)
+                {
+                    const number diag = A(i, i);
+                    if (diag == 0.0)
+                        UG_THROW("ChebyshevSmoother: zero diagonal in row " << i << ".");
+                    m_invDiag[i] = 1.0 / diag;
+                }
+
+                m_r.resize(n);
+                m_p.resize(n);
+                estimate_lambda_max();
+                return true;
+            }
+
+            virtual bool apply(vector_type &c, const vector_type &d)
+            {
+                VecScaleAssign(m_r, 1.0, d);
+                iterate(c, m_r);
+                return true;
+            }
+
+            virtual bool apply_update_defect(vector_type &c, vector_type &d)
+            {
+                iterate(c, d);
+                return true;
+            }
+
+            /**
+             * \return estimate of the largest eigenvalue of D^-1 A
+             */
+            number lambda_max() const
+            {
+                return m_lambdaMax;
+            }
+
+            virtual SmartPtr<base_type> clone()
+            {
+                return make_sp(new ChebyshevSmoother<TAlgebra>(m_degree, m_lowerFraction, m_upperFraction, m_powerSteps));
+            }
+
+        protected:
+            /// power iteration for the largest eigenvalue of D^-1 A
+            void estimate_lambda_max()
+            {
+                const matrix_type &A = m_spOp->get_matrix();
+                const size_t n = m_invDiag.size();
+
+                // deterministic start vector with components in all eigenvectors
+                for (size_t i = 0; i < n; i++)
+                    m_p[i] = 1.0 + std::sin(1.0 + i);
+
+                m_lambdaMax = 0.0;
+                for (int step = 0; step < m_powerSteps; step++)
+                {
+                    number norm = 0.0;
+                    for (size_t i = 0; i < n; i++)
+                        norm += m_p[i] * m_p[i];
+                    norm = std::sqrt(norm);
+                    if (norm == 0.0)
+                        break;
+                    for (size_t i = 0; i < n; i++)
+                        m_p[i] /= norm;
+
+                    A.apply(m_r, m_p);
+                    number lambda = 0.0;
+                    for (size_t i = 0; i < n; i++)
+                    {
+                        m_r[i] *= m_invDiag[i];
+                        lambda += m_r[i] * m_p[i];
+                    }
+                    m_lambdaMax = std::max(m_lambdaMax, std::fabs(lambda));
+                    VecScaleAssign(m_p, 1.0, m_r);
+                }
+            }
+
+            /**
+             * Chebyshev iteration for A c = d from c = 0, updates d to the new defect
+             */
+            void iterate(vector_type &c, vector_type &d)
+            {
+                const matrix_type &A = m_spOp->get_matrix();
+                const size_t n = m_invDiag.size();
+
+                const number upper = m_upperFraction * m_lambdaMax;
+                const number lower = m_lowerFraction * m_lambdaMax;
+                const number theta = 0.5 * (upper + lower);
+                const number delta = 0.5 * (upper - lower);
+                const number sigma = theta / delta;
+                number rho = 1.0 / sigma;
+
+                // p = D^-1 d / theta, c = p
+                for (size_t i = 0; i < n; i++)
+                {
+                    m_p[i] = m_invDiag[i] * d[i] / theta;
+                    c[i] = m_p[i];
+                }
+
+                for (int k = 1; k < m_degree; k++)
+                {
+                    A.matmul_minus(d, m_p);
+                    const number rhoNew = 1.0 / (2.0 * sigma - rho);
+                    const number scale = 2.0 * rhoNew / delta;
+                    for (size_t i = 0; i < n; i++)
+                    {
+                        m_p[i] = rhoNew * rho * m_p[i] + scale * m_invDiag[i] * d[i];
+                        c[i] += m_p[i];
+                    }
+                    rho = rhoNew;
+                }
+                A.matmul_minus(d, m_p);
+            }
+
+            int m_degree;
+            number m_lowerFraction;
+            number m_upperFraction;
+            int m_powerSteps;
+            number m_lambdaMax;
+            SmartPtr<MatrixOperator<matrix_type, vector_type>> m_spOp;
+            std::vector<number> m_invDiag;
+            vector_type m_r;
+            vector_type m_p;
+        };
+
+    } // namespace RegressionTest
+} // namespace ug
+
+#endif /* UG4TESTS_REGRESSION_TESTS_CHEBYSHEV_SMOOTHER_H */
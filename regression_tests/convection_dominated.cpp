@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "ug.h"
+#include "ugbase.h"
+#include "lib_disc/spatial_disc/disc_util/conv_shape.h"
+#include "../../ConvectionDiffusion/convection_diffusion_base.h"
+#include "../../ConvectionDiffusion/fv1/convection_diffusion_fv1.h"
+
+#include "testcase.h"
+#include "solver_setup.h"
+#include "convergence_history.h"
+
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Convection-dominated testcase
+         *
+         * Solves -εΔc + v·∇c = 0 on the Laplace domain with a strong constant velocity
+         * field and full upwinding in the FV1 discretization. The system is assembled
+         * once; solve() can then be called with different multigrid settings to find
+         * those that keep the iteration count bounded.
+         *
+         * \tparam dim Dimension of the problem
+         */
+        template <int dim>
+        class ConvectionDominated : public Testcase<dim>
+        {
+            typedef Testcase<dim> base_type;
+            typedef typename base_type::TAlgebra TAlgebra;
+            typedef typename base_type::vector_type vector_type;
+            typedef typename base_type::TDomain TDomain;
+            typedef typename base_type::TApproxSpace TApproxSpace;
+            typedef typename base_type::TDirichletBoundary TDirichletBoundary;
+            typedef typename base_type::TDomainDiscretization TDomainDiscretization;
+            typedef typename base_type::TGridFunction TGridFunction;
+            typedef ug::ConvectionDiffusionPlugin::ConvectionDiffusionFV1<TDomain> TConvDiff;
+            typedef ug::AssembledMultiGridCycle<TDomain, TAlgebra> GMG;
+
+        public:
+            /**
+             * Constructor
+             *
+             * \param[in]    grid        Name of the grid file
+             * \param[in]    reference   Name of the reference file
+             */
+            ConvectionDominated(std::string grid, std::string reference)
+                : base_type(grid, reference), m_diffusion(1e-3), m_velocity(dim, 0.0)
+            {
+                m_velocity[0] = 1.0;
+                if (dim > 1)
+                    m_velocity[1] = 0.5;
+            }
+
+            /**
+             * \param[in]    diffusion   diffusion coefficient ε
+             * \param[in]    velocity    constant velocity field
+             */
+            void set_coefficients(number diffusion, const std::vector<number> &velocity)
+            {
+                m_diffusion = diffusion;
+                m_velocity = velocity;
+            }
+
+            /**
+             * \param[in]    settings    multigrid settings used by run()
+             */
+            void set_gmg_settings(const GMGSettings &settings)
+            {
+                m_gmgSettings = settings;
+            }
+
+            /**
+             * Runs the convection-dominated testcase with the configured multigrid settings
+             */
+            void run()
+            {
+                AlgebraType algebra("CPU", 1);
+                ug::bridge::InitUG(dim, algebra);
+
+                // Domain
+                this->m_spDomain = make_sp(new TDomain());
+                LoadDomain(*this->m_spDomain, this->m_gridname.c_str());
+                this->refine(this->m_numRefs);
+
+                // Approximation Space
+                this->m_spApproxSpace = make_sp(new TApproxSpace(this->m_spDomain));
+                this->m_spApproxSpace->add("c", "Lagrange", 1);
+                this->m_spApproxSpace->init_top_surface();
+
+                // Element Discretization with full upwinding
+                SmartPtr<TConvDiff> cd = make_sp(new TConvDiff("c", "Inner"));
+                cd->set_diffusion(m_diffusion);
+                cd->set_velocity(m_velocity);
+                cd->set_reaction(0.0);
+                cd->set_upwind(make_sp(new FullUpwind<dim>()));
+                this->m_spElemDisc = cd;
+
+                // Dirichlet Boundary Conditions
+                SmartPtr<TDirichletBoundary> boundary = make_sp(new TDirichletBoundary());
+                boundary->add(-1, "c", "bndNegative");
+                boundary->add(1, "c", "bndPositive");
+
+                // Domain Discretization
+                this->m_spDomainDisc = make_sp(new TDomainDiscretization(this->m_spApproxSpace));
+                this->m_spDomainDisc->add(this->m_spElemDisc);
+                this->m_spDomainDisc->add(boundary);
+
+                // Assemble Linear Operator
+                m_spOp = make_sp(new AssembledLinearOperator<TAlgebra>(this->m_spDomainDisc));
+                m_spU = make_sp(new TGridFunction(this->m_spApproxSpace));
+                m_spB = make_sp(new TGridFunction(this->m_spApproxSpace));
+
+                m_spU->set(0.0);
+                this->m_spDomainDisc->adjust_solution(*m_spU);
+                this->m_spDomainDisc->assemble_linear(*m_spOp, *m_spB);
+
+                // Solve
+                m_lastSolve = solve(m_gmgSettings);
+                if (!m_lastSolve.converged)
+                    UG_THROW("ConvectionDominated: BiCGStab did not converge.");
+
+                // Save Solution
+                this->store_solution(*m_spU);
+            }
+
+            /**
+             * Solves the assembled system from a zero initial guess with BiCGStab and
+             * the given multigrid settings. The solution is kept in m_spU.
+             *
+             * \param[in]    settings    multigrid settings
+             * \return iteration count, convergence history and wall clock time of setup and solve
+             */
+            SolveStatistics solve(const GMGSettings &settings)
+            {
+                SmartPtr<GMG> gmg = CreateGMG<TDomain, TAlgebra>(this->m_spApproxSpace, settings);
+                SmartPtr<HistoryConvCheck<vector_type>> convCheck = make_sp(new HistoryConvCheck<vector_type>(100, 1e-12, 1e-6, false));
+
+                BiCGStab<vector_type> solver;
+                solver.set_preconditioner(gmg);
+                solver.set_convergence_check(convCheck);
+
+                m_spU->set(0.0);
+                this->m_spDomainDisc->adjust_solution(*m_spU);
+
+                SolveStatistics stats;
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                stats.converged = solver.init(m_spOp, *m_spU) && solver.apply(*m_spU, *m_spB);
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+                stats.seconds = elapsed.count();
+                stats.iterations = convCheck->step();
+                stats.history = convCheck->history();
+                return stats;
+            }
+
+            /**
+             * \return statistics of the solve performed by run()
+             */
+            const SolveStatistics &last_solve() const
+            {
+                return m_lastSolve;
+            }
+
+        protected:
+            SmartPtr<AssembledLinearOperator<TAlgebra>> m_spOp;
+            SmartPtr<TGridFunction> m_spU;
+            SmartPtr<TGridFunction> m_spB;
+            GMGSettings m_gmgSettings;
+            SolveStatistics m_lastSolve;
+            number m_diffusion;
+            std::vector<number> m_velocity;
+        };
+
+    } // namespace RegressionTest
+} // namespace ug
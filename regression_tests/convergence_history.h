@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef UG4TESTS_REGRESSION_TESTS_CONVERGENCE_HISTORY_H
+#define UG4TESTS_REGRESSION_TESTS_CONVERGENCE_HISTORY_H
+
+#include <chrono>
+#include <vector>
+
+#include "ug.h"
+#include "ugbase.h"
+#include "lib_algebra/operator/convergence_check.h"
+
+#include "phase_observer.h"
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Convergence check reporting every iteration of the solver as a span
+         *
+         * Behaves like StdConvCheck. A span "iteration" is open from the initial defect
+         * or the end of the previous iteration until the next defect is reported.
+         *
+         * \tparam TVector vector type
+         */
+        template <typename TVector>
+        class TracedConvCheck : public StdConvCheck<TVector>
+        {
+            typedef StdConvCheck<TVector> base_type;
+
+        public:
+            /**
+             * Constructor
+             *
+             * \param[in]    maxSteps        maximum number of iterations
+             * \param[in]    minDefect       absolute tolerance
+             * \param[in]    relReduction    relative tolerance
+             * \param[in]    verbose         print the defects
+             */
+            TracedConvCheck(int maxSteps, number minDefect, number relReduction, bool verbose)
+                : base_type(maxSteps, minDefect, relReduction, verbose), m_inIteration(false)
+            {
+            }
+
+            virtual void start_defect(number initialDefect)
+            {
+                base_type::start_defect(initialDefect);
+                stop_iteration_span();
+                start_iteration_span();
+            }
+
+            virtual void update_defect(number newDefect)
+            {
+                stop_iteration_span();
+                base_type::update_defect(newDefect);
+            }
+
+            virtual bool iteration_ended()
+            {
+                const bool ended = stop_iteration();
+                if (ended)
+                    stop_iteration_span();
+                else
+                    start_iteration_span();
+                return ended;
+            }
+
+            virtual SmartPtr<IConvergenceCheck<TVector>> clone()
+            {
+                return make_sp(new TracedConvCheck<TVector>(this->m_maxSteps, this->m_minDefect, this->m_relReduction, this->m_verbose));
+            }
+
+        protected:
+            /**
+             * \return true if the iteration has to stop, as decided by StdConvCheck
+             */
+            virtual bool stop_iteration()
+            {
+                return base_type::iteration_ended();
+            }
+
+            void start_iteration_span()
+            {
+                if (!m_inIteration)
+                    NotifySpanStarted("iteration");
+                m_inIteration = true;
+            }
+
+            void stop_iteration_span()
+            {
+                if (m_inIteration)
+                    NotifySpanStopped("iteration");
+                m_inIteration = false;
+            }
+
+            bool m_inIteration;
+        };
+
+        /**
+         * \brief Convergence check recording the defect of every iteration
+         *
+         * Behaves like TracedConvCheck, but keeps the defect norms of the last solve,
+         * starting with the initial defect. Optionally, the iteration is stopped as
+         * not converged once a wall clock time limit is exceeded.
+         *
+         * \tparam TVector vector type
+         */
+        template <typename TVector>
+        class HistoryConvCheck : public TracedConvCheck<TVector>
+        {
+            typedef TracedConvCheck<TVector> base_type;
+
+        public:
+            /**
+             * Constructor
+             *
+             * \param[in]    maxSteps        maximum number of iterations
+             * \param[in]    minDefect       absolute tolerance
+             * \param[in]    relReduction    relative tolerance
+             * \param[in]    verbose         print the defects
+             */
+            HistoryConvCheck(int maxSteps, number minDefect, number relReduction, bool verbose)
+                : base_type(maxSteps, minDefect, relReduction, verbose), m_timeLimit(0.0), m_timeLimitExceeded(false)
+            {
+            }
+
+            /**
+             * \param[in]    seconds     wall clock limit of the iteration, measured from the
+             *                           initial defect; 0 disables the limit
+             */
+            void set_time_limit(double seconds)
+            {
+                m_timeLimit = seconds;
+            }
+
+            /**
+             * \return true if the last iteration was stopped by the time limit
+             */
+            bool time_limit_exceeded() const
+            {
+                return m_timeLimitExceeded;
+            }
+
+            virtual void start_defect(number initialDefect)
+            {
+                m_history.clear();
+                m_history.push_back(initialDefect);
+                m_timeLimitExceeded = false;
+                m_start = std::chrono::steady_clock::now();
+                base_type::start_defect(initialDefect);
+            }
+
+            virtual void update_defect(number newDefect)
+            {
+                m_history.push_back(newDefect);
+                base_type::update_defect(newDefect);
+            }
+
+            virtual SmartPtr<IConvergenceCheck<TVector>> clone()
+            {
+                SmartPtr<HistoryConvCheck<TVector>> newCheck = make_sp(new HistoryConvCheck<TVector>(this->m_maxSteps, this->m_minDefect,
+                                                                                                      this->m_relReduction, this->m_verbose));
+                newCheck->set_time_limit(m_timeLimit);
+                return newCheck;
+            }
+
+            /**
+             * \return defect norms of the last solve, starting with the initial defect
+             */
+            const std::vector<number> &history() const
+            {
+                return m_history;
+            }
+
+        protected:
+            virtual bool stop_iteration()
+            {
+                if (m_timeLimit > 0.0 && !m_timeLimitExceeded)
+                {
+                    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_start;
+                    m_timeLimitExceeded = elapsed.count() > m_timeLimit;
+                }
+                return m_timeLimitExceeded || base_type::stop_iteration();
+            }
+
+            std::vector<number> m_history;
+            double m_timeLimit;
+            bool m_timeLimitExceeded;
+            std::chrono::steady_clock::time_point m_start;
+        };
+
+    } // namespace RegressionTest
+} // namespace ug
+
+#endif /* UG4TESTS_REGRESSION_TESTS_CONVERGENCE_HISTORY_H */
@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#include <string>
+#include <vector>
+
+#include "ug.h"
+#include "ugbase.h"
+#include "lib_disc/spatial_disc/user_data/linker/scale_add_linker.h"
+#include "../../ConvectionDiffusion/convection_diffusion_base.h"
+#include "../../ConvectionDiffusion/fv1/convection_diffusion_fv1.h"
+
+#include "testcase.h"
+#include "solver_setup.h"
+#include "convergence_history.h"
+
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Coupled three component reaction-diffusion testcase
+         *
+         * Solves the system
+         *      -Δc1 + k (c1 - c2)       = 0
+         *      -Δc2 + k (2c2 - c1 - c3) = 0
+         *      -Δc3 + k (c3 - c2)       = 0
+         * on the Laplace domain. The coupling terms are linked to the unknowns, so the
+         * system is assembled as Jacobian and defect and solved with a single Newton step,
+         * which is exact for this linear problem. Running it with CPUAlgebra and
+         * CPUBlockAlgebra<3> compares scalar and block storage; the solution is stored
+         * per vertex and component, so both algebras share one reference.
+         *
+         * \tparam dim Dimension of the problem
+         * \tparam TAlgebraType Algebra, CPUAlgebra or CPUBlockAlgebra<3>
+         */
+        template <int dim, typename TAlgebraType>
+        class CoupledSystem : public Testcase<dim, TAlgebraType>
+        {
+            typedef Testcase<dim, TAlgebraType> base_type;
+            typedef typename base_type::TAlgebra TAlgebra;
+            typedef typename base_type::vector_type vector_type;
+            typedef typename base_type::TDomain TDomain;
+            typedef typename base_type::TApproxSpace TApproxSpace;
+            typedef typename base_type::TDirichletBoundary TDirichletBoundary;
+            typedef typename base_type::TDomainDiscretization TDomainDiscretization;
+            typedef typename base_type::TGridFunction TGridFunction;
+            typedef ug::ConvectionDiffusionPlugin::ConvectionDiffusionFV1<TDomain> TConvDiff;
+            typedef ug::AssembledMultiGridCycle<TDomain, TAlgebra> GMG;
+            typedef ScaleAddLinker<number, dim, number> TLinker;
+
+            using base_type::base_type;
+
+        public:
+            /**
+             * Runs the coupled system testcase
+             *
+             * \param[in]    numBenchmarkRuns    number of repetitions of the SpMV and smoother benchmark
+             */
+            void run(int numBenchmarkRuns = 20)
+            {
+                AlgebraType algebra("CPU", TAlgebra::blockSize);
+                ug::bridge::InitUG(dim, algebra);
+
+                // Domain
+                this->m_spDomain = make_sp(new TDomain());
+                LoadDomain(*this->m_spDomain, this->m_gridname.c_str());
+                this->refine(this->m_numRefs);
+
+                // Approximation Space
+                this->m_spApproxSpace = make_sp(new TApproxSpace(this->m_spDomain));
+                this->m_spApproxSpace->add("c1", "Lagrange", 1);
+                this->m_spApproxSpace->add("c2", "Lagrange", 1);
+                this->m_spApproxSpace->add("c3", "Lagrange", 1);
+                this->m_spApproxSpace->init_top_surface();
+
+                // Element Discretizations, coupled by linked reaction terms
+                const number k = 10.0;
+                SmartPtr<TConvDiff> cd1 = make_sp(new TConvDiff("c1", "Inner"));
+                SmartPtr<TConvDiff> cd2 = make_sp(new TConvDiff("c2", "Inner"));
+                SmartPtr<TConvDiff> cd3 = make_sp(new TConvDiff("c3", "Inner"));
+                cd1->set_diffusion(1.0);
+                cd2->set_diffusion(1.0);
+                cd3->set_diffusion(1.0);
+
+                SmartPtr<TLinker> r1 = make_sp(new TLinker());
+                r1->add(k, cd1->value());
+                r1->add(-k, cd2->value());
+                cd1->set_reaction(r1);
+
+                SmartPtr<TLinker> r2 = make_sp(new TLinker());
+                r2->add(2.0 * k, cd2->value());
+                r2->add(-k, cd1->value());
+                r2->add(-k, cd3->value());
+                cd2->set_reaction(r2);
+
+                SmartPtr<TLinker> r3 = make_sp(new TLinker());
+                r3->add(k, cd3->value());
+                r3->add(-k, cd2->value());
+                cd3->set_reaction(r3);
+
+                // Dirichlet Boundary Conditions
+                SmartPtr<TDirichletBoundary> boundary = make_sp(new TDirichletBoundary());
+                boundary->add(-1, "c1", "bndNegative");
+                boundary->add(1, "c1", "bndPositive");
+                boundary->add(-0.5, "c2", "bndNegative");
+                boundary->add(0.5, "c2", "bndPositive");
+                boundary->add(1, "c3", "bndNegative");
+                boundary->add(0, "c3", "bndPositive");
+
+                // Domain Discretization
+                this->m_spDomainDisc = make_sp(new TDomainDiscretization(this->m_spApproxSpace));
+                this->m_spDomainDisc->add(cd1);
+                this->m_spDomainDisc->add(cd2);
+                this->m_spDomainDisc->add(cd3);
+                this->m_spDomainDisc->add(boundary);
+
+                // BiCGStab with GMG
+                SmartPtr<GMG> gmg = CreateGMG<TDomain, TAlgebra>(this->m_spApproxSpace);
+                SmartPtr<TracedConvCheck<vector_type>> convCheck = make_sp(new TracedConvCheck<vector_type>(100, 1e-12, 1e-6, false));
+                BiCGStab<vector_type> solver;
+                solver.set_preconditioner(gmg);
+                solver.set_convergence_check(convCheck);
+
+                // Assemble Jacobian and Defect
+                SmartPtr<AssembledLinearOperator<TAlgebra>> J = make_sp(new AssembledLinearOperator<TAlgebra>(this->m_spDomainDisc));
+                SmartPtr<TGridFunction> u = make_sp(new TGridFunction(this->m_spApproxSpace));
+                SmartPtr<TGridFunction> d = u->clone_without_values();
+                SmartPtr<TGridFunction> c = u->clone_without_values();
+
+                u->set(0.0);
+                this->m_spDomainDisc->adjust_solution(*u);
+
+                this->start_phase("assembly");
+                this->m_spDomainDisc->assemble_jacobian(*J, *u);
+                this->m_spDomainDisc->assemble_defect(*d, *u);
+                this->stop_phase("assembly");
+
+                // Solve J c = d, u = u - c
+                this->start_phase("solve");
+                c->set(0.0);
+                if (!solver.init(J, *u) || !solver.apply(*c, *d))
+                    UG_THROW("CoupledSystem: BiCGStab did not converge.");
+                VecScaleAdd(*u, 1.0, *u, -1.0, *c);
+                this->stop_phase("solve");
+                m_iterations = convCheck->step();
+
+                // Benchmark: SpMV and damped Jacobi smoothing on the Jacobian
+                for (int i = 0; i < numBenchmarkRuns; i++)
+                {
+                    this->start_phase("spmv");
+                    J->apply(*d, *u);
+                    this->stop_phase("spmv");
+                }
+
+                Jacobi<TAlgebra> smoother(0.66);
+                smoother.init(J, *u);
+                for (int i = 0; i < numBenchmarkRuns; i++)
+                {
+                    this->m_spDomainDisc->assemble_defect(*d, *u);
+                    this->start_phase("smoother");
+                    smoother.apply_update_defect(*c, *d);
+                    this->stop_phase("smoother");
+                }
+
+                // Save Solution
+                store_vertex_solution(*u);
+            }
+
+            /**
+             * \return number of BiCGStab iterations
+             */
+            int num_iterations() const
+            {
+                return m_iterations;
+            }
+
+        protected:
+            /**
+             * stores the solution ordered by surface vertex and component, independent of
+             * the DoF ordering and block size of the algebra
+             *
+             * \param[in]    u   solution
+             */
+            void store_vertex_solution(const TGridFunction &u)
+            {
+                typedef typename TGridFunction::template traits<Vertex>::const_iterator TIterator;
+
+                SmartPtr<std::vector<double>> sol = make_sp(new std::vector<double>);
+                std::vector<DoFIndex> ind;
+                for (TIterator it = u.template begin<Vertex>(); it != u.template end<Vertex>(); ++it)
+                {
+                    for (size_t fct = 0; fct < u.num_fct(); fct++)
+                    {
+                        u.inner_dof_indices(*it, fct, ind);
+                        sol->push_back(DoFRef(u, ind[0]));
+                    }
+                }
+                this->m_spSolution = sol;
+                NotifyProblemSize(sol->size());
+            }
+
+            int m_iterations;
+        };
+
+    } // namespace RegressionTest
+} // namespace ug
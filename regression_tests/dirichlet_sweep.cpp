@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "ug.h"
+#include "ugbase.h"
+#include "lib_disc/spatial_disc/user_data/const_user_data.h"
+#include "lib_disc/spatial_disc/user_data/std_glob_pos_data.h"
+#include "../../ConvectionDiffusion/convection_diffusion_base.h"
+#include "../../ConvectionDiffusion/fv1/convection_diffusion_fv1.h"
+
+#include "testcase.h"
+#include "solver_setup.h"
+#include "convergence_history.h"
+#include "recycling_solver.h"
+
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Source term sin(π (t + Σ (1 + i + 0.1 t) x_i)) of the Dirichlet sweep
+         *
+         * Wave vector and phase change slowly with the sweep parameter t, so the source
+         * terms of a sweep are related but do not span a low-dimensional space.
+         *
+         * \tparam dim Dimension of the problem
+         */
+        template <int dim>
+        class SweepSource : public StdGlobPosData<SweepSource<dim>, number, dim, void>
+        {
+        public:
+            SweepSource() : m_parameter(0.0) {}
+
+            /**
+             * \param[in]    parameter   sweep parameter t
+             */
+            void set_parameter(number parameter)
+            {
+                m_parameter = parameter;
+            }
+
+            inline void evaluate(number &value, const MathVector<dim> &x, number time, int si) const
+            {
+                number phase = m_parameter;
+                for (int d = 0; d < dim; d++)
+                    phase += (1.0 + d + 0.1 * m_parameter) * x[d];
+                value = std::sin(PI * phase);
+            }
+
+        protected:
+            number m_parameter;
+        };
+
+        /**
+         * \brief Sweep over the Dirichlet values and the source term of the Laplace problem
+         *
+         * Solves the Poisson problem for a sequence of slowly changing boundary values
+         * on bndNegative and bndPositive and a slowly changing source term. The operator
+         * is assembled and the solver set up once, only the right-hand side is
+         * reassembled for every solve. The systems are solved by a RecyclingSolver, GCR
+         * preconditioned with GMG, which with set_recycling() deflates every solve by the
+         * directions of the previous ones; without it is plain truncated GCR. The
+         * convergence check is absolute, so that the reduction of the initial defect by
+         * the recycled space saves iterations.
+         *
+         * \tparam dim Dimension of the problem
+         */
+        template <int dim>
+        class DirichletSweep : public Testcase<dim>
+        {
+            typedef Testcase<dim> base_type;
+            typedef typename base_type::TAlgebra TAlgebra;
+            typedef typename base_type::vector_type vector_type;
+            typedef typename base_type::TDomain TDomain;
+            typedef typename base_type::TApproxSpace TApproxSpace;
+            typedef typename base_type::TDirichletBoundary TDirichletBoundary;
+            typedef typename base_type::TDomainDiscretization TDomainDiscretization;
+            typedef typename base_type::TGridFunction TGridFunction;
+            typedef ug::ConvectionDiffusionPlugin::ConvectionDiffusionFV1<TDomain> TConvDiff;
+            typedef ug::AssembledMultiGridCycle<TDomain, TAlgebra> GMG;
+
+        public:
+            /**
+             * Constructor
+             *
+             * \param[in]    grid        Name of the grid file
+             * \param[in]    reference   Name of the reference file
+             */
+            DirichletSweep(std::string grid, std::string reference)
+                : base_type(grid, reference), m_numSolves(20), m_numRecycled(0)
+            {
+            }
+
+            /**
+             * \param[in]    numSolves   number of solves in the sweep
+             */
+            void set_num_solves(int numSolves)
+            {
+                m_numSolves = numSolves;
+            }
+
+            /**
+             * \param[in]    numVectors  number of recycled directions, 0 disables recycling
+             */
+            void set_recycling(size_t numVectors)
+            {
+                m_numRecycled = numVectors;
+            }
+
+            /**
+             * Runs the sweep
+             */
+            void run()
+            {
+                AlgebraType algebra("CPU", 1);
+                ug::bridge::InitUG(dim, algebra);
+
+                // Domain
+                this->m_spDomain = make_sp(new TDomain());
+                LoadDomain(*this->m_spDomain, this->m_gridname.c_str());
+                this->refine(this->m_numRefs);
+
+                // Approximation Space
+                this->m_spApproxSpace = make_sp(new TApproxSpace(this->m_spDomain));
+                this->m_spApproxSpace->add("c", "Lagrange", 1);
+                this->m_spApproxSpace->init_top_surface();
+
+                // Element Discretization
+                SmartPtr<TConvDiff> cd = make_sp(new TConvDiff("c", "Inner"));
+                cd->set_diffusion(1.0);
+                cd->set_reaction(0.0);
+                m_spSource = make_sp(new SweepSource<dim>());
+                cd->set_source(m_spSource);
+                this->m_spElemDisc = cd;
+
+                // Dirichlet Boundary Conditions with adjustable values
+                m_spNegative = make_sp(new ConstUserNumber<dim>(-1.0));
+                m_spPositive = make_sp(new ConstUserNumber<dim>(1.0));
+                SmartPtr<TDirichletBoundary> boundary = make_sp(new TDirichletBoundary());
+                boundary->add(m_spNegative, "c", "bndNegative");
+                boundary->add(m_spPositive, "c", "bndPositive");
+
+                // Domain Discretization
+                this->m_spDomainDisc = make_sp(new TDomainDiscretization(this->m_spApproxSpace));
+                this->m_spDomainDisc->add(this->m_spElemDisc);
+                this->m_spDomainDisc->add(boundary);
+
+                // Solver: GCR with GMG, recycling if enabled
+                const number minDefect = 1e-9;
+                const number reduction = 1e-10;
+                SmartPtr<TracedConvCheck<vector_type>> convCheck = make_sp(new TracedConvCheck<vector_type>(100, minDefect, reduction, false));
+                SmartPtr<RecyclingSolver<vector_type>> solver = make_sp(new RecyclingSolver<vector_type>(m_numRecycled));
+                solver->set_preconditioner(CreateGMG<TDomain, TAlgebra>(this->m_spApproxSpace));
+                solver->set_convergence_check(convCheck);
+
+                // Assemble Linear Operator once
+                SmartPtr<AssembledLinearOperator<TAlgebra>> op = make_sp(new AssembledLinearOperator<TAlgebra>(this->m_spDomainDisc));
+                SmartPtr<TGridFunction> u = make_sp(new TGridFunction(this->m_spApproxSpace));
+                SmartPtr<TGridFunction> b = make_sp(new TGridFunction(this->m_spApproxSpace));
+                const GridLevel gl = u->grid_level();
+
+                this->start_phase("assembly");
+                u->set(0.0);
+                this->m_spDomainDisc->adjust_solution(*u);
+                this->m_spDomainDisc->assemble_linear(*op, *b);
+                this->stop_phase("assembly");
+
+                this->start_phase("solver setup");
+                solver->init(op, *u);
+                this->stop_phase("solver setup");
+
+                // Sweep
+                m_iterations.clear();
+                number initialResidual = 0.0;
+                for (int k = 0; k < m_numSolves; k++)
+                {
+                    m_spNegative->set(-1.0 - 0.5 * std::sin(0.3 * k));
+                    m_spPositive->set(1.0 + 0.25 * std::cos(0.2 * k));
+                    m_spSource->set_parameter(0.05 * k);
+
+                    this->start_phase("assembly rhs");
+                    u->set(0.0);
+                    this->m_spDomainDisc->adjust_solution(*u);
+                    this->m_spDomainDisc->assemble_rhs(*b, *u, gl);
+                    this->stop_phase("assembly rhs");
+
+                    if (k + 1 == m_numSolves)
+                        initialResidual = this->residual_norm(*op, *u, *b);
+
+                    this->start_phase("solve");
+                    if (!solver->apply(*u, *b))
+                        UG_THROW("DirichletSweep: linear solver failed in solve " << k << ".");
+                    this->stop_phase("solve");
+                    m_iterations.push_back(convCheck->step());
+                }
+
+                this->record_residual(*op, *u, *b, initialResidual, minDefect, reduction);
+
+                // Save Solution of the last solve
+                this->store_solution(*u);
+            }
+
+            /**
+             * \return GCR iterations of every solve of the sweep
+             */
+            const std::vector<int> &iterations() const
+            {
+                return m_iterations;
+            }
+
+            /**
+             * \return GCR iterations summed over the sweep
+             */
+            int total_iterations() const
+            {
+                int total = 0;
+                for (int it : m_iterations)
+                    total += it;
+                return total;
+            }
+
+        protected:
+            int m_numSolves;
+            size_t m_numRecycled;
+            SmartPtr<ConstUserNumber<dim>> m_spNegative;
+            SmartPtr<ConstUserNumber<dim>> m_spPositive;
+            SmartPtr<SweepSource<dim>> m_spSource;
+            std::vector<int> m_iterations;
+        };
+
+    } // namespace RegressionTest
+} // namespace ug
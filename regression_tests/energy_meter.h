@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef UG4TESTS_REGRESSION_TESTS_ENERGY_METER_H
+#define UG4TESTS_REGRESSION_TESTS_ENERGY_METER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#ifdef __unix__
+#include <dirent.h>
+#endif
+
+#include "phase_observer.h"
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Energy counters of the Linux powercap RAPL interface
+         *
+         * Uses the package zones intel-rapl:N and their dram subzones, which the kernel
+         * also exposes on AMD processors; psys is skipped since it contains the packages.
+         * The counters cover whole sockets, so the energy of other processes on the
+         * machine is included and parallel processes on one node count it repeatedly.
+         * Since 2020 the counters are readable by root only on many systems; without
+         * readable zones available() is false and unavailable_reason() tells why.
+         */
+        class RaplCounters
+        {
+        public:
+            typedef std::vector<uint64_t> reading_type;
+
+            /**
+             * \param[in] root   powercap directory in sysfs
+             */
+            explicit RaplCounters(const std::string &root = "/sys/class/powercap")
+            {
+                discover(root);
+            }
+
+            bool available() const
+            {
+                return !m_zones.empty();
+            }
+
+            const std::string &unavailable_reason() const
+            {
+                return m_reason;
+            }
+
+            /**
+             * \return names of the zones, e.g. "package-0" or "dram"
+             */
+            std::vector<std::string> zone_names() const
+            {
+                std::vector<std::string> names;
+                for (const Zone &zone : m_zones)
+                    names.push_back(zone.name);
+                return names;
+            }
+
+            /**
+             * \return current counter values of all zones in microjoules
+             */
+            reading_type read() const
+            {
+                reading_type values;
+                for (const Zone &zone : m_zones)
+                {
+                    uint64_t value = 0;
+                    read_value(zone.path + "/energy_uj", value);
+                    values.push_back(value);
+                }
+                return values;
+            }
+
+            /**
+             * \return energy in joules of all zones between two readings, taking one
+             *         wraparound of each counter into account
+             */
+            double joules(const reading_type &before, const reading_type &after) const
+            {
+                double microjoules = 0.0;
+                for (size_t i = 0; i < m_zones.size() && i < before.size() && i < after.size(); i++)
+                {
+                    if (after[i] >= before[i])
+                        microjoules += after[i] - before[i];
+                    else
+                        microjoules += m_zones[i].range - before[i] + after[i];
+                }
+                return 1e-6 * microjoules;
+            }
+
+        protected:
+            struct Zone
+            {
+                std::string name;
+                std::string path;
+                uint64_t range;
+            };
+
+            static bool read_value(const std::string &filename, uint64_t &value)
+            {
+                std::ifstream in(filename);
+                return (bool)(in >> value);
+            }
+
+            static std::string read_name(const std::string &dir)
+            {
+                std::ifstream in(dir + "/name");
+                std::string name;
+                std::getline(in, name);
+                return name;
+            }
+
+            void discover(const std::string &root)
+            {
+#ifdef __unix__
+                std::vector<std::string> entries;
+                if (DIR *dir = opendir(root.c_str()))
+                {
+                    while (dirent *entry = readdir(dir))
+                        entries.push_back(entry->d_name);
+                    closedir(dir);
+                }
+                std::sort(entries.begin(), entries.end());
+
+                bool unreadable = false;
+                for (const std::string &entry : entries)
+                {
+                    if (entry.compare(0, 11, "intel-rapl:") != 0)
+                        continue;
+
+                    // packages are intel-rapl:N, their subzones intel-rapl:N:M
+                    const bool package = entry.find(':', 11) == std::string::npos;
+                    const std::string path = root + "/" + entry;
+                    Zone zone;
+                    zone.name = read_name(path);
+                    zone.path = path;
+                    if (package ? zone.name == "psys" : zone.name != "dram")
+                        continue;
+
+                    uint64_t value;
+                    if (!read_value(path + "/energy_uj", value))
+                    {
+                        unreadable = true;
+                        continue;
+                    }
+                    if (!read_value(path + "/max_energy_range_uj", zone.range) || zone.range == 0)
+                        zone.range = UINT64_MAX;
+                    m_zones.push_back(zone);
+                }
+
+                if (m_zones.empty())
+                    m_reason = unreadable ? "the RAPL energy counters in " + root + " are not readable, usually root only"
+                                          : "no RAPL energy counters in " + root;
+#else
+                m_reason = "the powercap interface is only available on Linux";
+#endif
+            }
+
+            std::vector<Zone> m_zones;
+            std::string m_reason;
+        };
+
+        /**
+         * \return RAPL counters of the machine, discovered at the first call
+         */
+        inline const RaplCounters &GlobalRaplCounters()
+        {
+            static RaplCounters counters;
+            return counters;
+        }
+
+        /**
+         * \brief Reports the energy of the testcase phases
+         *
+         * Reads the RAPL counters around every phase and prints, at the end of each test,
+         * the joules per phase, per call and, for the problem size last reported by the
+         * testcase, per degree of freedom. Without readable counters a note is printed
+         * once and nothing is measured.
+         */
+        class EnergyMeter : public ::testing::EmptyTestEventListener, public PhaseObserver
+        {
+        public:
+            explicit EnergyMeter(const RaplCounters &counters = GlobalRaplCounters()) : m_counters(counters), m_numDoFs(0)
+            {
+                if (!m_counters.available())
+                    std::cout << "EnergyMeter: " << m_counters.unavailable_reason() << ", no energy measurement" << std::endl;
+            }
+
+            virtual void OnTestProgramStart(const ::testing::UnitTest & /*unitTest*/)
+            {
+                AddPhaseObserver(this);
+            }
+
+            virtual void OnTestProgramEnd(const ::testing::UnitTest & /*unitTest*/)
+            {
+                RemovePhaseObserver(this);
+            }
+
+            virtual void OnTestStart(const ::testing::TestInfo & /*testInfo*/)
+            {
+                m_joules.clear();
+                m_calls.clear();
+                m_start.clear();
+                m_numDoFs = 0;
+                m_testStart = m_counters.read();
+            }
+
+            virtual void OnTestEnd(const ::testing::TestInfo &testInfo)
+            {
+                if (!m_counters.available())
+                    return;
+
+                std::cout << "energy " << testInfo.test_suite_name() << "." << testInfo.name() << ": "
+                          << m_counters.joules(m_testStart, m_counters.read()) << " J total" << std::endl;
+                for (std::map<std::string, double>::const_iterator it = m_joules.begin(); it != m_joules.end(); ++it)
+                {
+                    const size_t calls = m_calls[it->first];
+                    std::cout << "  " << std::left << std::setw(24) << it->first << std::right << std::setw(12) << it->second << " J"
+                              << std::setw(8) << calls << " calls" << std::setw(12) << it->second / calls << " J per call";
+                    if (m_numDoFs > 0)
+                        std::cout << std::setw(12) << it->second / calls / m_numDoFs << " J per DoF";
+                    std::cout << std::endl;
+                }
+            }
+
+            virtual void phase_started(const std::string &phase)
+            {
+                if (m_counters.available())
+                    m_start[phase] = m_counters.read();
+            }
+
+            virtual void phase_stopped(const std::string &phase, double /*seconds*/)
+            {
+                if (!m_counters.available() || m_start.find(phase) == m_start.end())
+                    return;
+                m_joules[phase] += m_counters.joules(m_start[phase], m_counters.read());
+                m_calls[phase]++;
+            }
+
+            virtual void problem_size(size_t numDoFs)
+            {
+                m_numDoFs = numDoFs;
+            }
+
+        protected:
+            const RaplCounters &m_counters;
+            RaplCounters::reading_type m_testStart;
+            std::map<std::string, RaplCounters::reading_type> m_start;
+            std::map<std::string, double> m_joules;
+            std::map<std::string, size_t> m_calls;
+            size_t m_numDoFs;
+        };
+
+    } // namespace RegressionTest
+} // namespace ug
+
+#endif /* UG4TESTS_REGRESSION_TESTS_ENERGY_METER_H */
@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef UG4TESTS_REGRESSION_TESTS_FUSED_JACOBI_H
+#define UG4TESTS_REGRESSION_TESTS_FUSED_JACOBI_H
+
+#include <utility>
+#include <vector>
+
+#include "ug.h"
+#include "ugbase.h"
+#include "lib_algebra/operator/interface/linear_iterator.h"
+#include "lib_algebra/operator/interface/matrix_operator.h"
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Damped Jacobi smoother on flat CSR arrays
+         *
+         * Computes the same iterates as Jacobi<TAlgebra>, but copies the matrix into plain
+         * CSR arrays and stores the damped inverse diagonal at setup, so the kernels are
+         * tight loops over contiguous memory that the compiler can vectorize. Besides the
+         * ILinearIterator interface used by the multigrid, smooth() performs several
+         * steps x += damping * D^-1 (b - Ax) with defect computation and update fused into
+         * one pass per step. apply_update_defect(), the step the multigrid calls, computes
+         * correction and defect update in one pass over the matrix, too; for this the
+         * damped inverse diagonal is folded into the matrix columns at setup, which
+         * doubles the memory of the matrix values. Serial only; scalar algebras only.
+         *
+         * \tparam TAlgebra algebra type
+         */
+        template <typename TAlgebra>
+        class FusedJacobi : public ILinearIterator<typename TAlgebra::vector_type>
+        {
+        public:
+            typedef typename TAlgebra::vector_type vector_type;
+            typedef typename TAlgebra::matrix_type matrix_type;
+            typedef ILinearIterator<vector_type> base_type;
+
+            /**
+             * \param[in]    damping     damping factor
+             */
+            explicit FusedJacobi(number damping = 0.66) : m_damping(damping) {}
+
+            virtual const char *name() const { return "FusedJacobi"; }
+
+            virtual bool supports_parallel() const { return false; }
+
+            virtual bool init(SmartPtr<ILinearOperator<vector_type>> J, const vector_type &u)
+            {
+                return init(J);
+            }
+
+            virtual bool init(SmartPtr<ILinearOperator<vector_type>> L)
+            {
+                SmartPtr<MatrixOperator<matrix_type, vector_type>> op = L.template cast_dynamic<MatrixOperator<matrix_type, vector_type>>();
+                if (op.invalid())
+                    UG_THROW("FusedJacobi: operator is not a matrix.");
+
+                const matrix_type &A = op->get_matrix();
+                const size_t n = A.num_rows();
+                m_rowStart.assign(1, 0);
+                m_cols.clear();
+                m_values.clear();
+                m_scaledValues.clear();
+                m_invDiag.assign(n, 0.0);
+                for (size_t i = 0; i < n; i++)
+                {
+                    for (typename matrix_type::const_row_iterator it = A.begin_row(i); it != A.end_row(i); ++it)
+                    {
+                        m_cols.push_back(it.index());
+                        m_values.push_back(it.value());
+                        if (it.index() == i)
+                            m_invDiag[i] = it.value();
+                    }
+                    m_rowStart.push_back(m_cols.size());
+
+                    if (m_invDiag[i] == 0.0)
+                        UG_THROW("FusedJacobi: zero diagonal in row " << i << ".");
+                    m_invDiag[i] = m_damping / m_invDiag[i];
+                }
+
+                // A * damping * D^-1, the defect update of apply_update_defect()
+                m_scaledValues.resize(m_values.size());
+                for (size_t k = 0; k < m_values.size(); k++)
+                    m_scaledValues[k] = m_values[k] * m_invDiag[m_cols[k]];
+                return true;
+            }
+
+            /// c = damping * D^-1 d
+            virtual bool apply(vector_type &c, const vector_type &d)
+            {
+                const size_t n = m_invDiag.size();
+                const number *invDiag = m_invDiag.data();
+                for (size_t i = 0; i < n; i++)
+                    c[i] = invDiag[i] * d[i];
+                return true;
+            }
+
+            /**
+             * c = damping * D^-1 d, d -= A c in one pass over the matrix: the new defect is
+             * d - (A damping D^-1) d; it is written to a buffer and copied back, since the
+             * update needs all entries of the old defect
+             */
+            virtual bool apply_update_defect(vector_type &c, vector_type &d)
+            {
+                const size_t n = m_invDiag.size();
+                m_xNew.resize(n);
+
+                const size_t *rowStart = m_rowStart.data();
+                const size_t *cols = m_cols.data();
+                const number *scaledValues = m_scaledValues.data();
+                const number *invDiag = m_invDiag.data();
+                number *dNew = m_xNew.data();
+                for (size_t i = 0; i < n; i++)
+                {
+                    number sum = 0.0;
+                    for (size_t k = rowStart[i]; k < rowStart[i + 1]; k++)
+                        sum += scaledValues[k] * d[cols[k]];
+                    c[i] = invDiag[i] * d[i];
+                    dNew[i] = d[i] - sum;
+                }
+
+                for (size_t i = 0; i < n; i++)
+                    d[i] = dNew[i];
+                return true;
+            }
+
+            /**
+             * Performs numSteps Jacobi steps x += damping * D^-1 (b - Ax), each in one pass
+             * over matrix and vectors
+             *
+             * \param[in,out]    x           iterate
+             * \param[in]        b           right-hand side
+             * \param[in]        numSteps    number of steps
+             */
+            void smooth(vector_type &x, const vector_type &b, int numSteps)
+            {
+                const size_t n = m_invDiag.size();
+                m_xOld.resize(n);
+                m_xNew.resize(n);
+                for (size_t i = 0; i < n; i++)
+                    m_xOld[i] = x[i];
+
+                const size_t *rowStart = m_rowStart.data();
+                const size_t *cols = m_cols.data();
+                const number *values = m_values.data();
+                const number *invDiag = m_invDiag.data();
+                for (int step = 0; step < numSteps; step++)
+                {
+                    const number *xOld = m_xOld.data();
+                    number *xNew = m_xNew.data();
+                    for (size_t i = 0; i < n; i++)
+                    {
+                        number defect = b[i];
+                        for (size_t k = rowStart[i]; k < rowStart[i + 1]; k++)
+                            defect -= values[k] * xOld[cols[k]];
+                        xNew[i] = xOld[i] + invDiag[i] * defect;
+                    }
+                    std::swap(m_xOld, m_xNew);
+                }
+
+                for (size_t i = 0; i < n; i++)
+                    x[i] = m_xOld[i];
+            }
+
+            virtual SmartPtr<base_type> clone()
+            {
+                return make_sp(new FusedJacobi<TAlgebra>(m_damping));
+            }
+
+        protected:
+            number m_damping;
+            std::vector<size_t> m_rowStart;
+            std::vector<size_t> m_cols;
+            std::vector<number> m_values;
+            /// matrix values times the damped inverse diagonal of their column
+            std::vector<number> m_scaledValues;
+            /// damping times the inverse diagonal
+            std::vector<number> m_invDiag;
+            std::vector<number> m_xOld;
+            std::vector<number> m_xNew;
+        };
+
+    } // namespace RegressionTest
+} // namespace ug
+
+#endif /* UG4TESTS_REGRESSION_TESTS_FUSED_JACOBI_H */
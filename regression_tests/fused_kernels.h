@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef UG4TESTS_REGRESSION_TESTS_FUSED_KERNELS_H
+#define UG4TESTS_REGRESSION_TESTS_FUSED_KERNELS_H
+
+#include <vector>
+
+#ifdef UG_PARALLEL
+#include <mpi.h>
+#include "pcl/pcl.h"
+#endif
+
+#include "ug.h"
+#include "ugbase.h"
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Batch of global sums that are reduced together
+         *
+         * The local contributions of several dot products are reduced with a single
+         * non-blocking allreduce, which is started with start() and completed with
+         * wait(). Work placed between both calls hides the reduction latency. Requires
+         * MPI-3 (MPI_Iallreduce) in parallel builds.
+         */
+        class ReductionBatch
+        {
+        public:
+            explicit ReductionBatch(size_t size) : m_local(size, 0.0), m_global(size, 0.0) {}
+
+            /// local contribution of the i-th sum
+            number &local(size_t i) { return m_local[i]; }
+
+            /// global value of the i-th sum, valid after wait()
+            number global(size_t i) const { return m_global[i]; }
+
+            void start()
+            {
+                #ifdef UG_PARALLEL
+                if (pcl::NumProcs() > 1)
+                {
+                    MPI_Iallreduce(m_local.data(), m_global.data(), (int)m_local.size(), MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD, &m_request);
+                    return;
+                }
+                #endif
+                m_global = m_local;
+            }
+
+            void wait()
+            {
+                #ifdef UG_PARALLEL
+                if (pcl::NumProcs() > 1)
+                    MPI_Wait(&m_request, MPI_STATUS_IGNORE);
+                #endif
+            }
+
+            /// blocking reduction
+            void reduce()
+            {
+                start();
+                wait();
+            }
+
+        protected:
+            std::vector<number> m_local;
+            std::vector<number> m_global;
+            #ifdef UG_PARALLEL
+            MPI_Request m_request;
+            #endif
+        };
+
+        /*
+         * Fused vector kernels for Krylov methods. Each kernel combines vector updates and
+         * the dot products of the updated vectors into a single pass over memory. The dot
+         * products are local; they have to be summed up over all processes, e.g. with a
+         * ReductionBatch. All kernels expect scalar entries (CPUAlgebra).
+         */
+
+        /**
+         * \return local part of (a, b)
+         */
+        template <typename TVector>
+        inline number LocalVecProd(const TVector &a, const TVector &b)
+        {
+            number sum = 0.0;
+            for (size_t i = 0; i < a.size(); i++)
+                sum += a[i] * b[i];
+            return sum;
+        }
+
+        /**
+         * Computes the local parts of (a, b) and (c, d) in one pass
+         */
+        template <typename TVector>
+        inline void FusedVecProd(const TVector &a, const TVector &b, const TVector &c, const TVector &d,
+                                 number &ab, number &cd)
+        {
+            number s0 = 0.0, s1 = 0.0;
+            for (size_t i = 0; i < a.size(); i++)
+            {
+                s0 += a[i] * b[i];
+                s1 += c[i] * d[i];
+            }
+            ab = s0;
+            cd = s1;
+        }
+
+        /**
+         * Computes the local parts of (a0, b0), (a1, b1) and (a2, b2) in one pass
+         */
+        template <typename TVector>
+        inline void FusedVecProd(const TVector &a0, const TVector &b0, const TVector &a1, const TVector &b1,
+                                 const TVector &a2, const TVector &b2, number &d0, number &d1, number &d2)
+        {
+            number s0 = 0.0, s1 = 0.0, s2 = 0.0;
+            for (size_t i = 0; i < a0.size(); i++)
+            {
+                s0 += a0[i] * b0[i];
+                s1 += a1[i] * b1[i];
+                s2 += a2[i] * b2[i];
+            }
+            d0 = s0;
+            d1 = s1;
+            d2 = s2;
+        }
+
+        /**
+         * Computes the local parts of the five dot products (a0, b0), ..., (a4, b4) in one pass
+         */
+        template <typename TVector>
+        inline void FusedVecProd(const TVector &a0, const TVector &b0, const TVector &a1, const TVector &b1,
+                                 const TVector &a2, const TVector &b2, const TVector &a3, const TVector &b3,
+                                 const TVector &a4, const TVector &b4,
+                                 number &d0, number &d1, number &d2, number &d3, number &d4)
+        {
+            number s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0, s4 = 0.0;
+            for (size_t i = 0; i < a0.size(); i++)
+            {
+                s0 += a0[i] * b0[i];
+                s1 += a1[i] * b1[i];
+                s2 += a2[i] * b2[i];
+                s3 += a3[i] * b3[i];
+                s4 += a4[i] * b4[i];
+            }
+            d0 = s0;
+            d1 = s1;
+            d2 = s2;
+            d3 = s3;
+            d4 = s4;
+        }
+
+        /**
+         * BiCGStab update x += alpha * p + omega * s, r = s - omega * t with the local parts
+         * of (r, r) and (rStar, r), in one pass
+         */
+        template <typename TVector>
+        inline void FusedBiCGStabUpdate(TVector &x, TVector &r, number alpha, const TVector &p, number omega,
+                                        const TVector &sHat, const TVector &s, const TVector &t, const TVector &rStar,
+                                        number &rr, number &rStarR)
+        {
+            number s0 = 0.0, s1 = 0.0;
+            for (size_t i = 0; i < x.size(); i++)
+            {
+                x[i] += alpha * p[i] + omega * sHat[i];
+                const number ri = s[i] - omega * t[i];
+                r[i] = ri;
+                s0 += ri * ri;
+                s1 += rStar[i] * ri;
+            }
+            rr = s0;
+            rStarR = s1;
+        }
+
+        /**
+         * CG update x += alpha * p, r -= alpha * q in one pass
+         *
+         * \return local part of (r, r)
+         */
+        template <typename TVector>
+        inline number FusedCGUpdate(TVector &x, TVector &r, number alpha, const TVector &p, const TVector &q)
+        {
+            number norm2 = 0.0;
+            for (size_t i = 0; i < x.size(); i++)
+            {
+                x[i] += alpha * p[i];
+                const number ri = r[i] - alpha * q[i];
+                r[i] = ri;
+                norm2 += ri * ri;
+            }
+            return norm2;
+        }
+
+    } // namespace RegressionTest
+} // namespace ug
+
+#endif /* UG4TESTS_REGRESSION_TESTS_FUSED_KERNELS_H */
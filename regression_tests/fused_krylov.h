@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef UG4TESTS_REGRESSION_TESTS_FUSED_KRYLOV_H
+#define UG4TESTS_REGRESSION_TESTS_FUSED_KRYLOV_H
+
+#include <cmath>
+
+#include "ug.h"
+#include "ugbase.h"
+#include "lib_algebra/operator/interface/preconditioned_linear_operator_inverse.h"
+
+#include "fused_kernels.h"
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Common parts of the Krylov solvers built on the fused kernels
+         *
+         * In parallel, results of the operator are made unique so that dot products with
+         * them can be summed locally; preconditioned vectors are consistent.
+         */
+        template <typename TVector>
+        class FusedKrylovSolver : public IPreconditionedLinearOperatorInverse<TVector>
+        {
+        public:
+            typedef TVector vector_type;
+            typedef IPreconditionedLinearOperatorInverse<TVector> base_type;
+
+            using base_type::convergence_check;
+            using base_type::linear_operator;
+            using base_type::preconditioner;
+
+            virtual bool supports_parallel() const
+            {
+                if (preconditioner().valid())
+                    return preconditioner()->supports_parallel();
+                return true;
+            }
+
+        protected:
+            void check_storage(const vector_type &x, const vector_type &b)
+            {
+                #ifdef UG_PARALLEL
+                if (!b.has_storage_type(PST_ADDITIVE) || !x.has_storage_type(PST_CONSISTENT))
+                    UG_THROW(this->name() << ": Inadequate storage format of vectors.");
+                #endif
+            }
+
+            /// c = M^-1 d, or c = d without preconditioner
+            void precondition(vector_type &c, const vector_type &d)
+            {
+                if (preconditioner().valid())
+                {
+                    if (!preconditioner()->apply(c, d))
+                        UG_THROW(this->name() << ": preconditioner failed.");
+                    return;
+                }
+
+                VecScaleAssign(c, 1.0, d);
+                #ifdef UG_PARALLEL
+                c.change_storage_type(PST_CONSISTENT);
+                #endif
+            }
+
+            /// f = A u, made unique
+            void apply_operator(vector_type &f, const vector_type &u)
+            {
+                linear_operator()->apply(f, u);
+                make_unique(f);
+            }
+
+            void make_unique(vector_type &v)
+            {
+                #ifdef UG_PARALLEL
+                v.change_storage_type(PST_UNIQUE);
+                #endif
+            }
+        };
+
+        /**
+         * \brief Preconditioned BiCGStab on fused vector kernels
+         *
+         * Same iteration as BiCGStab, but the vector updates and dot products are merged
+         * into five passes over memory per iteration instead of about nine. The residual
+         * norm and the next rho are computed while x and r are updated, and (t, s) and
+         * (t, t) share one pass and one reduction.
+         *
+         * \tparam TVector vector type with scalar entries
+         */
+        template <typename TVector>
+        class FusedBiCGStab : public FusedKrylovSolver<TVector>
+        {
+        public:
+            typedef TVector vector_type;
+            typedef FusedKrylovSolver<TVector> base_type;
+
+            using base_type::convergence_check;
+            using base_type::linear_operator;
+
+            virtual const char *name() const { return "FusedBiCGStab"; }
+
+            virtual bool apply_return_defect(vector_type &x, vector_type &b)
+            {
+                this->check_storage(x, b);
+
+                SmartPtr<vector_type> spR = b.clone_without_values(), spRStar = b.clone_without_values();
+                SmartPtr<vector_type> spP = b.clone_without_values(), spV = b.clone_without_values();
+                SmartPtr<vector_type> spS = b.clone_without_values(), spT = b.clone_without_values();
+                SmartPtr<vector_type> spQ = x.clone_without_values(), spSHat = x.clone_without_values();
+                vector_type &r = *spR, &rStar = *spRStar, &p = *spP, &v = *spV, &s = *spS, &t = *spT;
+                vector_type &q = *spQ, &sHat = *spSHat;
+
+                // r = b - Ax
+                VecScaleAssign(r, 1.0, b);
+                linear_operator()->apply_sub(r, x);
+                this->make_unique(r);
+                VecScaleAssign(rStar, 1.0, r);
+
+                ReductionBatch red(2);
+                FusedVecProd(r, r, rStar, r, red.local(0), red.local(1));
+                red.reduce();
+
+                convergence_check()->set_symbol('%');
+                convergence_check()->set_name(name());
+                convergence_check()->start_defect(std::sqrt(red.global(0)));
+
+                number rho = red.global(1), rhoOld = 1.0;
+                number alpha = 1.0, omega = 1.0;
+
+                for (bool first = true; !convergence_check()->iteration_ended(); first = false)
+                {
+                    if (first)
+                        VecScaleAssign(p, 1.0, r);
+                    else
+                    {
+                        const number beta = (rho / rhoOld) * (alpha / omega);
+                        VecScaleAdd(p, 1.0, r, beta, p, -beta * omega, v);
+                    }
+
+                    this->precondition(q, p);
+                    this->apply_operator(v, q);
+
+                    ReductionBatch rv(1);
+                    rv.local(0) = LocalVecProd(rStar, v);
+                    rv.reduce();
+                    if (rv.global(0) == 0.0)
+                        UG_THROW(name() << ": breakdown, (r*, v) = 0.");
+                    alpha = rho / rv.global(0);
+
+                    VecScaleAdd(s, 1.0, r, -alpha, v);
+                    this->precondition(sHat, s);
+                    this->apply_operator(t, sHat);
+
+                    FusedVecProd(t, s, t, t, red.local(0), red.local(1));
+                    red.reduce();
+                    omega = (red.global(1) != 0.0) ? red.global(0) / red.global(1) : 0.0;
+
+                    FusedBiCGStabUpdate(x, r, alpha, q, omega, sHat, s, t, rStar, red.local(0), red.local(1));
+                    red.reduce();
+
+                    convergence_check()->update_defect(std::sqrt(red.global(0)));
+                    rhoOld = rho;
+                    rho = red.global(1);
+                    if (omega == 0.0 || rho == 0.0)
+                        break;
+                }
+
+                VecScaleAssign(b, 1.0, r);
+                return convergence_check()->post();
+            }
+        };
+
+        /**
+         * \brief Preconditioned CG on fused vector kernels
+         *
+         * x and r are updated together with the computation of (r, r). The residual norm
+         * is reduced together with (z, r) after the preconditioner application, so every
+         * iteration has two global reductions; the preconditioner application of the last
+         * iteration is wasted in exchange.
+         *
+         * \tparam TVector vector type with scalar entries
+         */
+        template <typename TVector>
+        class FusedCG : public FusedKrylovSolver<TVector>
+        {
+        public:
+            typedef TVector vector_type;
+            typedef FusedKrylovSolver<TVector> base_type;
+
+            using base_type::convergence_check;
+            using base_type::linear_operator;
+
+            virtual const char *name() const { return "FusedCG"; }
+
+            virtual bool apply_return_defect(vector_type &x, vector_type &b)
+            {
+                this->check_storage(x, b);
+
+                SmartPtr<vector_type> spR = b.clone_without_values(), spQ = b.clone_without_values();
+                SmartPtr<vector_type> spZ = x.clone_without_values(), spP = x.clone_without_values();
+                vector_type &r = *spR, &q = *spQ, &z = *spZ, &p = *spP;
+
+                // r = b - Ax, z = M^-1 r
+                VecScaleAssign(r, 1.0, b);
+                linear_operator()->apply_sub(r, x);
+                this->make_unique(r);
+                this->precondition(z, r);
+
+                ReductionBatch red(2);
+                FusedVecProd(r, r, z, r, red.local(0), red.local(1));
+                red.reduce();
+
+                convergence_check()->set_symbol('%');
+                convergence_check()->set_name(name());
+                convergence_check()->start_defect(std::sqrt(red.global(0)));
+
+                number rho = red.global(1);
+                VecScaleAssign(p, 1.0, z);
+
+                while (!convergence_check()->iteration_ended())
+                {
+                    this->apply_operator(q, p);
+
+                    ReductionBatch pq(1);
+                    pq.local(0) = LocalVecProd(p, q);
+                    pq.reduce();
+                    if (pq.global(0) == 0.0)
+                        UG_THROW(name() << ": breakdown, (p, Ap) = 0.");
+                    const number alpha = rho / pq.global(0);
+
+                    red.local(0) = FusedCGUpdate(x, r, alpha, p, q);
+                    this->precondition(z, r);
+                    red.local(1) = LocalVecProd(z, r);
+                    red.reduce();
+
+                    convergence_check()->update_defect(std::sqrt(red.global(0)));
+                    if (convergence_check()->iteration_ended())
+                        break;
+
+                    const number beta = red.global(1) / rho;
+                    rho = red.global(1);
+                    VecScaleAdd(p, 1.0, z, beta, p);
+                }
+
+                VecScaleAssign(b, 1.0, r);
+                return convergence_check()->post();
+            }
+        };
+
+    } // namespace RegressionTest
+} // namespace ug
+
+#endif /* UG4TESTS_REGRESSION_TESTS_FUSED_KRYLOV_H */
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef UG4TESTS_REGRESSION_TESTS_GALERKIN_PRODUCT_H
+#define UG4TESTS_REGRESSION_TESTS_GALERKIN_PRODUCT_H
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "ug.h"
+#include "ugbase.h"
+
+#include "phase_observer.h"
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Sparse triple product Ac = R A P with cached symbolic phase
+         *
+         * The symbolic phase computes the sparsity pattern of Ac once; as long as the
+         * patterns of R, A and P do not change, e.g. after reassembly of A with new
+         * coefficients, only the numeric phase has to be repeated. The numeric phase
+         * computes the rows of Ac in parallel, each thread accumulating into its own
+         * dense row buffer of the size of the coarse space.
+         */
+        class GalerkinProduct
+        {
+        public:
+            typedef CPUAlgebra::matrix_type matrix_type;
+
+            /**
+             * \param[in]    numThreads  threads of the numeric phase, 0 for all hardware threads
+             */
+            explicit GalerkinProduct(size_t numThreads = 0) : m_numThreads(numThreads), m_numCols(0)
+            {
+                if (m_numThreads == 0)
+                    m_numThreads = std::max(1u, std::thread::hardware_concurrency());
+            }
+
+            /**
+             * Computes and caches the sparsity pattern of R A P
+             */
+            void symbolic(const matrix_type &R, const matrix_type &A, const matrix_type &P)
+            {
+                if (R.num_cols() != A.num_rows() || A.num_cols() != P.num_rows())
+                    UG_THROW("GalerkinProduct: sizes of R, A and P do not match.");
+
+                m_numCols = P.num_cols();
+                m_rowStart.assign(1, 0);
+                m_cols.clear();
+
+                std::vector<bool> marker(m_numCols, false);
+                std::vector<size_t> rowCols;
+                for (size_t i = 0; i < R.num_rows(); i++)
+                {
+                    rowCols.clear();
+                    for (matrix_type::const_row_iterator itR = R.begin_row(i); itR != R.end_row(i); ++itR)
+                        for (matrix_type::const_row_iterator itA = A.begin_row(itR.index()); itA != A.end_row(itR.index()); ++itA)
+                            for (matrix_type::const_row_iterator itP = P.begin_row(itA.index()); itP != P.end_row(itA.index()); ++itP)
+                            {
+                                if (marker[itP.index()])
+                                    continue;
+                                marker[itP.index()] = true;
+                                rowCols.push_back(itP.index());
+                            }
+
+                    std::sort(rowCols.begin(), rowCols.end());
+                    for (size_t c : rowCols)
+                        marker[c] = false;
+                    m_cols.insert(m_cols.end(), rowCols.begin(), rowCols.end());
+                    m_rowStart.push_back(m_cols.size());
+                }
+                m_values.assign(m_cols.size(), 0.0);
+            }
+
+            /**
+             * Computes the values of R A P on the cached pattern in parallel
+             */
+            void numeric(const matrix_type &R, const matrix_type &A, const matrix_type &P)
+            {
+                if (m_rowStart.size() != R.num_rows() + 1 || m_numCols != P.num_cols())
+                    UG_THROW("GalerkinProduct: numeric phase without matching symbolic phase.");
+
+                ScopedSpan span("Galerkin product");
+                const size_t numRows = R.num_rows();
+                const size_t numThreads = std::min(m_numThreads, std::max<size_t>(numRows, 1));
+                std::vector<std::thread> threads;
+                for (size_t t = 0; t < numThreads; t++)
+                {
+                    const size_t begin = numRows * t / numThreads;
+                    const size_t end = numRows * (t + 1) / numThreads;
+                    threads.push_back(std::thread(&GalerkinProduct::numeric_rows, this, std::cref(R), std::cref(A), std::cref(P), begin, end));
+                }
+                for (std::thread &thread : threads)
+                    thread.join();
+            }
+
+            /**
+             * Writes the result of the last numeric phase to a matrix
+             */
+            void copy_to(matrix_type &Ac) const
+            {
+                const size_t numRows = m_rowStart.size() - 1;
+                Ac.resize_and_clear(numRows, m_numCols);
+                for (size_t i = 0; i < numRows; i++)
+                    for (size_t k = m_rowStart[i]; k < m_rowStart[i + 1]; k++)
+                        Ac(i, m_cols[k]) = m_values[k];
+                Ac.defragment();
+            }
+
+            /**
+             * Computes Ac = R A P, reusing the cached pattern if its sizes match
+             */
+            void multiply(matrix_type &Ac, const matrix_type &R, const matrix_type &A, const matrix_type &P)
+            {
+                if (m_rowStart.size() != R.num_rows() + 1 || m_numCols != P.num_cols())
+                    symbolic(R, A, P);
+                numeric(R, A, P);
+                copy_to(Ac);
+            }
+
+            /**
+             * \return number of non-zeros of the product
+             */
+            size_t num_nonzeros() const
+            {
+                return m_cols.size();
+            }
+
+            /**
+             * \return bytes of the cached pattern and values
+             */
+            size_t memory() const
+            {
+                return m_rowStart.size() * sizeof(size_t) + m_cols.size() * sizeof(size_t) + m_values.size() * sizeof(number);
+            }
+
+        protected:
+            void numeric_rows(const matrix_type &R, const matrix_type &A, const matrix_type &P, size_t begin, size_t end)
+            {
+                ScopedSpan span("Galerkin product rows");
+                std::vector<number> row(m_numCols, 0.0);
+                for (size_t i = begin; i < end; i++)
+                {
+                    for (matrix_type::const_row_iterator itR = R.begin_row(i); itR != R.end_row(i); ++itR)
+                        for (matrix_type::const_row_iterator itA = A.begin_row(itR.index()); itA != A.end_row(itR.index()); ++itA)
+                        {
+                            const number ra = itR.value() * itA.value();
+                            for (matrix_type::const_row_iterator itP = P.begin_row(itA.index()); itP != P.end_row(itA.index()); ++itP)
+                                row[itP.index()] += ra * itP.value();
+                        }
+
+                    for (size_t k = m_rowStart[i]; k < m_rowStart[i + 1]; k++)
+                    {
+                        m_values[k] = row[m_cols[k]];
+                        row[m_cols[k]] = 0.0;
+                    }
+                }
+            }
+
+            size_t m_numThreads;
+            size_t m_numCols;
+            std::vector<size_t> m_rowStart;
+            std::vector<size_t> m_cols;
+            std::vector<number> m_values;
+        };
+
+    } // namespace RegressionTest
+} // namespace ug
+
+#endif /* UG4TESTS_REGRESSION_TESTS_GALERKIN_PRODUCT_H */
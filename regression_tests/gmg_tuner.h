@@ -0,0 +1,284 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef UG4TESTS_REGRESSION_TESTS_GMG_TUNER_H
+#define UG4TESTS_REGRESSION_TESTS_GMG_TUNER_H
+
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ug.h"
+#include "ugbase.h"
+
+#include "solver_setup.h"
+#include "benchmark_runner.h"
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Candidate values of the multigrid parameters searched by the GMGTuner
+         */
+        struct GMGTuningSpace
+        {
+            GMGTuningSpace()
+                : baseLevels({0, 1, 2}), numSmooth({1, 2, 3, 4}), dampings({0.5, 0.6, 0.66, 0.7, 0.8}),
+                  cycleTypes({"V", "W"}), maxSweeps(3), repetitions(3)
+            {
+            }
+
+            std::vector<int> baseLevels;
+            /// candidates of both the number of pre- and post-smoothing steps
+            std::vector<int> numSmooth;
+            std::vector<number> dampings;
+            std::vector<std::string> cycleTypes;
+            /// maximum number of sweeps over all parameters
+            int maxSweeps;
+            /// solves per configuration, the median time counts
+            int repetitions;
+        };
+
+        /**
+         * \brief Evaluated configuration of the GMGTuner
+         */
+        struct TuningResult
+        {
+            GMGSettings settings;
+            /// statistics of the last solve, with the median time of all solves
+            SolveStatistics stats;
+            /// stopped early because it could no longer beat the best configuration
+            bool terminated;
+        };
+
+        /**
+         * \brief Auto-tuner of base level, smoothing steps, damping and cycle type
+         *
+         * Searches the time-to-solution optimum by coordinate descent: starting from the
+         * given settings, every parameter is varied over its candidates while the others
+         * are kept, and the fastest value is taken over. Sweeps are repeated until no
+         * parameter changes. Each configuration is solved with a time limit equal to the
+         * best time so far, so poor configurations are terminated early; configurations
+         * that fail to converge or throw are discarded. A configuration is rated by the
+         * median time of several solves, a single sample would let timing noise decide.
+         */
+        class GMGTuner
+        {
+        public:
+            /// solves with the given settings, stopping as not converged after timeLimit seconds (0: no limit)
+            typedef std::function<SolveStatistics(const GMGSettings &settings, double timeLimit)> solve_function;
+
+            /**
+             * \param[in]    solve   solve function of the problem to tune, e.g. Laplace::solve
+             * \param[in]    space   candidate values of the parameters
+             */
+            GMGTuner(solve_function solve, const GMGTuningSpace &space = GMGTuningSpace())
+                : m_solve(solve), m_space(space), m_bestSeconds(std::numeric_limits<double>::max())
+            {
+            }
+
+            /**
+             * Runs the search
+             *
+             * \param[in]    start   initial settings, e.g. the hand-picked ones
+             * \return the fastest settings found
+             */
+            GMGSettings tune(const GMGSettings &start)
+            {
+                m_results.clear();
+                m_evaluated.clear();
+                m_bestSeconds = std::numeric_limits<double>::max();
+                m_best = start;
+
+                if (!evaluate(start))
+                    UG_THROW("GMGTuner: the initial settings do not converge.");
+
+                for (int sweep = 0; sweep < m_space.maxSweeps; sweep++)
+                {
+                    const std::string before = key(m_best);
+
+                    for (int baseLevel : m_space.baseLevels)
+                    {
+                        GMGSettings candidate = m_best;
+                        candidate.baseLevel = baseLevel;
+                        evaluate(candidate);
+                    }
+                    for (int numPre : m_space.numSmooth)
+                    {
+                        GMGSettings candidate = m_best;
+                        candidate.numPreSmooth = numPre;
+                        evaluate(candidate);
+                    }
+                    for (int numPost : m_space.numSmooth)
+                    {
+                        GMGSettings candidate = m_best;
+                        candidate.numPostSmooth = numPost;
+                        evaluate(candidate);
+                    }
+                    if (m_best.smoother == "jacobi" || m_best.smoother == "fused-jacobi")
+                    {
+                        for (number damping : m_space.dampings)
+                        {
+                            GMGSettings candidate = m_best;
+                            candidate.damping = damping;
+                            evaluate(candidate);
+                        }
+                    }
+                    for (const std::string &cycleType : m_space.cycleTypes)
+                    {
+                        GMGSettings candidate = m_best;
+                        candidate.cycleType = cycleType;
+                        evaluate(candidate);
+                    }
+
+                    if (key(m_best) == before)
+                        break;
+                }
+
+                return m_best;
+            }
+
+            /**
+             * \return the fastest settings of the last search
+             */
+            const GMGSettings &best() const
+            {
+                return m_best;
+            }
+
+            /**
+             * \return time to solution of the fastest settings
+             */
+            double best_seconds() const
+            {
+                return m_bestSeconds;
+            }
+
+            /**
+             * \return all evaluated configurations in the order of evaluation
+             */
+            const std::vector<TuningResult> &results() const
+            {
+                return m_results;
+            }
+
+            /**
+             * Writes the fastest settings as config file that can be read with ReadGMGSettings
+             *
+             * \param[in]    filename    name of the config file
+             */
+            void write_config(const std::string &filename) const
+            {
+                std::ofstream out(filename);
+                if (!out)
+                    UG_THROW("GMGTuner: could not open '" << filename << "'.");
+
+                out << "# time to solution " << m_bestSeconds << " s\n";
+                WriteGMGSettings(out, m_best);
+            }
+
+        protected:
+            /// unique key of the tuned parameters of a configuration
+            std::string key(const GMGSettings &settings) const
+            {
+                std::ostringstream ss;
+                WriteGMGSettings(ss, settings);
+                return ss.str();
+            }
+
+            /**
+             * Solves with the given settings unless they were evaluated before
+             *
+             * \return true if the configuration converged
+             */
+            bool evaluate(const GMGSettings &settings)
+            {
+                const std::string k = key(settings);
+                if (m_evaluated.count(k))
+                    return m_evaluated[k];
+
+                TuningResult result;
+                result.settings = settings;
+                result.terminated = false;
+
+                const double timeLimit = m_results.empty() ? 0.0 : m_bestSeconds;
+                std::vector<double> seconds;
+                for (int rep = 0; rep < m_space.repetitions; rep++)
+                {
+                    SolveStatistics stats;
+                    try
+                    {
+                        stats = m_solve(settings, timeLimit);
+                    }
+                    catch (UGError &err)
+                    {
+                        UG_LOG("GMGTuner: configuration failed: " << err.get_msg() << "\n");
+                        stats.converged = false;
+                    }
+
+                    result.stats = stats;
+                    if (!stats.converged)
+                        break;
+                    seconds.push_back(stats.seconds);
+                }
+                if (result.stats.converged)
+                    result.stats.seconds = Median(seconds);
+                result.terminated = !result.stats.converged && timeLimit > 0.0 && result.stats.seconds >= timeLimit;
+
+                m_results.push_back(result);
+                m_evaluated[k] = result.stats.converged;
+
+                if (result.stats.converged && result.stats.seconds < m_bestSeconds)
+                {
+                    m_bestSeconds = result.stats.seconds;
+                    m_best = settings;
+                }
+                return result.stats.converged;
+            }
+
+            solve_function m_solve;
+            GMGTuningSpace m_space;
+            double m_bestSeconds;
+            GMGSettings m_best;
+            std::vector<TuningResult> m_results;
+            std::map<std::string, bool> m_evaluated;
+        };
+
+    } // namespace RegressionTest
+} // namespace ug
+
+#endif /* UG4TESTS_REGRESSION_TESTS_GMG_TUNER_H */
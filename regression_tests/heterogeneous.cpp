@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "ug.h"
+#include "ugbase.h"
+#include "lib_disc/spatial_disc/user_data/const_user_data.h"
+#include "../../ConvectionDiffusion/convection_diffusion_base.h"
+#include "../../ConvectionDiffusion/fv1/convection_diffusion_fv1.h"
+
+#include "testcase.h"
+#include "solver_setup.h"
+#include "convergence_history.h"
+
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Anisotropic, heterogeneous diffusion testcase
+         *
+         * Solves -∇·(K∇c) = 0 on a sphere whose interior is split into the subsets
+         * "Inner" and "InnerHigh". K is the anisotropic tensor diag(1, ε, ..., ε) in
+         * "Inner" and jumps by the factor κ in "InnerHigh". Both the anisotropy and the
+         * jump degrade the point smoother, so the iteration count and the time to solve
+         * are the quantities checked against a budget.
+         *
+         * \tparam dim Dimension of the problem
+         */
+        template <int dim>
+        class Heterogeneous : public Testcase<dim>
+        {
+            typedef Testcase<dim> base_type;
+            typedef typename base_type::TAlgebra TAlgebra;
+            typedef typename base_type::vector_type vector_type;
+            typedef typename base_type::TDomain TDomain;
+            typedef typename base_type::TApproxSpace TApproxSpace;
+            typedef typename base_type::TDirichletBoundary TDirichletBoundary;
+            typedef typename base_type::TDomainDiscretization TDomainDiscretization;
+            typedef typename base_type::TGridFunction TGridFunction;
+            typedef ug::ConvectionDiffusionPlugin::ConvectionDiffusionFV1<TDomain> TConvDiff;
+            typedef ug::AssembledMultiGridCycle<TDomain, TAlgebra> GMG;
+
+        public:
+            /**
+             * Constructor
+             *
+             * \param[in]    grid        Name of the grid file
+             * \param[in]    reference   Name of the reference file
+             */
+            Heterogeneous(std::string grid, std::string reference)
+                : base_type(grid, reference), m_anisotropy(1e-2), m_jump(1e3)
+            {
+            }
+
+            /**
+             * \param[in]    anisotropy  ratio ε of the transversal to the axial diffusion
+             * \param[in]    jump        ratio κ of the diffusion in "InnerHigh" to "Inner"
+             */
+            void set_coefficients(number anisotropy, number jump)
+            {
+                m_anisotropy = anisotropy;
+                m_jump = jump;
+            }
+
+            /**
+             * Runs the heterogeneous testcase
+             */
+            void run()
+            {
+                AlgebraType algebra("CPU", 1);
+                ug::bridge::InitUG(dim, algebra);
+
+                // Domain
+                this->m_spDomain = make_sp(new TDomain());
+                LoadDomain(*this->m_spDomain, this->m_gridname.c_str());
+                this->refine(this->m_numRefs);
+
+                // Approximation Space
+                this->m_spApproxSpace = make_sp(new TApproxSpace(this->m_spDomain));
+                this->m_spApproxSpace->add("c", "Lagrange", 1);
+                this->m_spApproxSpace->init_top_surface();
+
+                // Element Discretizations: one per subset with its own diffusion tensor
+                SmartPtr<TConvDiff> cdLow = make_sp(new TConvDiff("c", "Inner"));
+                cdLow->set_diffusion(diffusion_tensor(1.0));
+                cdLow->set_reaction(0.0);
+                this->m_spElemDisc = cdLow;
+
+                SmartPtr<TConvDiff> cdHigh = make_sp(new TConvDiff("c", "InnerHigh"));
+                cdHigh->set_diffusion(diffusion_tensor(m_jump));
+                cdHigh->set_reaction(0.0);
+
+                // Dirichlet Boundary Conditions
+                SmartPtr<TDirichletBoundary> boundary = make_sp(new TDirichletBoundary());
+                boundary->add(-1, "c", "bndNegative");
+                boundary->add(1, "c", "bndPositive");
+
+                // Domain Discretization
+                this->m_spDomainDisc = make_sp(new TDomainDiscretization(this->m_spApproxSpace));
+                this->m_spDomainDisc->add(cdLow);
+                this->m_spDomainDisc->add(cdHigh);
+                this->m_spDomainDisc->add(boundary);
+
+                // Geometric Multigrid Preconditioner
+                SmartPtr<GMG> gmg = CreateGMG<TDomain, TAlgebra>(this->m_spApproxSpace);
+
+                // Convergence Check
+                SmartPtr<HistoryConvCheck<vector_type>> convCheck = make_sp(new HistoryConvCheck<vector_type>(100, 1e-12, 1e-6, false));
+
+                // BiCGStab Solver
+                BiCGStab<vector_type> solver;
+                solver.set_preconditioner(gmg);
+                solver.set_convergence_check(convCheck);
+
+                // Assemble Linear Operator
+                SmartPtr<AssembledLinearOperator<TAlgebra>> op = make_sp(new AssembledLinearOperator<TAlgebra>(this->m_spDomainDisc));
+                SmartPtr<TGridFunction> u = make_sp(new TGridFunction(this->m_spApproxSpace));
+                SmartPtr<TGridFunction> b = make_sp(new TGridFunction(this->m_spApproxSpace));
+
+                u->set(0.0);
+                this->m_spDomainDisc->adjust_solution(*u);
+                this->m_spDomainDisc->assemble_linear(*op, *b);
+
+                // Solve
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                m_stats.converged = solver.init(op, *u) && solver.apply(*u, *b);
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                m_stats.seconds = elapsed.count();
+                m_stats.iterations = convCheck->step();
+                m_stats.history = convCheck->history();
+
+                // Save Solution
+                this->store_solution(*u);
+            }
+
+            /**
+             * \return iteration count, history and wall clock time of GMG setup and solve
+             */
+            const SolveStatistics &statistics() const
+            {
+                return m_stats;
+            }
+
+        protected:
+            /**
+             * \param[in]    scale   scaling of the tensor
+             * \return the anisotropic diffusion tensor scale * diag(1, ε, ..., ε)
+             */
+            SmartPtr<ConstUserMatrix<dim>> diffusion_tensor(number scale) const
+            {
+                SmartPtr<ConstUserMatrix<dim>> tensor = make_sp(new ConstUserMatrix<dim>(0.0));
+                tensor->set_entry(0, 0, scale);
+                for (int d = 1; d < dim; d++)
+                    tensor->set_entry(d, d, scale * m_anisotropy);
+                return tensor;
+            }
+
+            SolveStatistics m_stats;
+            number m_anisotropy;
+            number m_jump;
+        };
+
+    } // namespace RegressionTest
+} // namespace ug
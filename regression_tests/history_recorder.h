@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef UG4TESTS_REGRESSION_TESTS_HISTORY_RECORDER_H
+#define UG4TESTS_REGRESSION_TESTS_HISTORY_RECORDER_H
+
+#include <ctime>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#ifdef UG_PARALLEL
+#include "pcl/pcl.h"
+#endif
+
+#include "benchmark_history.h"
+#include "phase_observer.h"
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Appends the timings of every passed test to the benchmark history
+         *
+         * Collects the phase timings of the testcases and the results of the
+         * BenchmarkRunner while a test runs and appends them, together with the total
+         * time of the test, when it has passed. Failed and skipped tests are not
+         * recorded. In parallel runs only process 0 writes. The recorder observes the
+         * testcases from the start until the end of the test program.
+         */
+        class HistoryRecorder : public ::testing::EmptyTestEventListener, public PhaseObserver
+        {
+        public:
+            /**
+             * \param[in] filename   history file, created if it does not exist
+             */
+            explicit HistoryRecorder(const std::string &filename)
+                : m_filename(filename), m_gitHash(BuildGitHash()), m_compiler(BuildCompiler()), m_flags(BuildFlags()),
+                  m_machine(MachineFingerprint())
+            {
+            }
+
+            virtual void OnTestProgramStart(const ::testing::UnitTest & /*unitTest*/)
+            {
+                AddPhaseObserver(this);
+            }
+
+            virtual void OnTestProgramEnd(const ::testing::UnitTest & /*unitTest*/)
+            {
+                RemovePhaseObserver(this);
+            }
+
+            virtual void OnTestStart(const ::testing::TestInfo & /*testInfo*/)
+            {
+                m_phases.clear();
+                m_metrics.clear();
+            }
+
+            virtual void phase_stopped(const std::string &phase, double seconds)
+            {
+                m_phases[phase] += seconds;
+            }
+
+            virtual void metric_recorded(const std::string &name, double value)
+            {
+                m_metrics.push_back(std::make_pair(name, value));
+            }
+
+            virtual void OnTestEnd(const ::testing::TestInfo &testInfo)
+            {
+#ifdef UG_PARALLEL
+                if (pcl::ProcRank() != 0)
+                    return;
+#endif
+                if (!testInfo.result()->Passed())
+                    return;
+
+                const std::string test = std::string(testInfo.test_suite_name()) + "." + testInfo.name();
+                std::vector<HistoryRecord> records;
+                for (std::map<std::string, double>::const_iterator it = m_phases.begin(); it != m_phases.end(); ++it)
+                    records.push_back(record(test, "phase/" + it->first, it->second));
+                for (const std::pair<std::string, double> &metric : m_metrics)
+                    records.push_back(record(test, "benchmark/" + metric.first, metric.second));
+                records.push_back(record(test, "total", 1e-3 * testInfo.result()->elapsed_time()));
+
+                if (!AppendHistory(m_filename, records))
+                    std::cerr << "HistoryRecorder: could not append to '" << m_filename << "'" << std::endl;
+            }
+
+        protected:
+            HistoryRecord record(const std::string &test, const std::string &metric, double value) const
+            {
+                HistoryRecord r;
+                r.time = (long long)std::time(nullptr);
+                r.gitHash = m_gitHash;
+                r.compiler = m_compiler;
+                r.flags = m_flags;
+                r.machine = m_machine;
+                r.test = test;
+                r.metric = metric;
+                r.value = value;
+                return r;
+            }
+
+            std::string m_filename;
+            std::string m_gitHash;
+            std::string m_compiler;
+            std::string m_flags;
+            std::string m_machine;
+            std::map<std::string, double> m_phases;
+            std::vector<std::pair<std::string, double>> m_metrics;
+        };
+
+    } // namespace RegressionTest
+} // namespace ug
+
+#endif /* UG4TESTS_REGRESSION_TESTS_HISTORY_RECORDER_H */
@@ -30,6 +30,8 @@
  * GNU Lesser General Public License for more details.
  */
 
+#include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <iterator>
 #include <string>
@@ -39,12 +41,12 @@
 #include "ugbase.h"
 #include "../../ConvectionDiffusion/convection_diffusion_base.h"
 #include "../../ConvectionDiffusion/fv1/convection_diffusion_fv1.h"
-#include "lib_algebra/operator/linear_solver/bicgstab.h"
-#include "lib_algebra/operator/preconditioner/preconditioners.h"
-#include "lib_algebra/operator/linear_solver/agglomerating_solver.h"
-#include "../../SuperLU/super_lu.h"
 
 #include "testcase.h"
+#include "solver_setup.h"
+#include "snapshot.h"
+#include "convergence_history.h"
+#include "energy_meter.h"
 
 
 namespace ug
@@ -53,39 +55,92 @@ namespace ug
     {
         /**
          * \brief Laplace testcase
+         *
+         * \tparam dim Dimension of the problem
          */
-        class Laplace : public Testcase<3>
+        template <int dim>
+        class Laplace : public Testcase<dim>
         {
-            typedef Testcase<3> base_type;
+            typedef Testcase<dim> base_type;
+            typedef typename base_type::TAlgebra TAlgebra;
+            typedef typename base_type::vector_type vector_type;
+            typedef typename base_type::TDomain TDomain;
+            typedef typename base_type::TApproxSpace TApproxSpace;
+            typedef typename base_type::TDirichletBoundary TDirichletBoundary;
+            typedef typename base_type::TDirichletBoundaryBase TDirichletBoundaryBase;
+            typedef typename base_type::TDomainDiscretization TDomainDiscretization;
+            typedef typename base_type::TGridFunction TGridFunction;
             typedef ug::ConvectionDiffusionPlugin::ConvectionDiffusionFV1<TDomain> TConvDiff;
             typedef ug::AssembledMultiGridCycle<TDomain, TAlgebra> GMG;
 
-            using Testcase::Testcase;
-
         public:
+            /**
+             * Constructor
+             *
+             * \param[in]    grid        Name of the grid file
+             * \param[in]    reference   Name of the reference file
+             */
+            Laplace(std::string grid, std::string reference)
+                : base_type(grid, reference), m_krylovMethod("bicgstab"), m_bNestedIteration(false), m_iterations(0)
+            {
+            }
+
+            /**
+             * \param[in]    nested  if true, the initial guess is computed by nested iteration:
+             *                       the problem is solved on every coarser level of the grid
+             *                       hierarchy and prolongated as start for the next finer one
+             */
+            void set_nested_iteration(bool nested)
+            {
+                m_bNestedIteration = nested;
+            }
+
+            /**
+             * \param[in]    method  Krylov method, "bicgstab" by default; see CreateKrylovSolver
+             */
+            void set_krylov_method(const std::string &method)
+            {
+                m_krylovMethod = method;
+            }
+
+            /**
+             * \param[in]    settings    multigrid settings of the preconditioner of run()
+             */
+            void set_gmg_settings(const GMGSettings &settings)
+            {
+                m_gmgSettings = settings;
+            }
+
             /**
              * Runs the Laplace testcase
              */
             void run()
             {
                 AlgebraType algebra("CPU", 1);
-                ug::bridge::InitUG(3, algebra);
+                ug::bridge::InitUG(dim, algebra);
 
                 // Domain
-                m_spDomain = make_sp(new TDomain());
-                LoadDomain(*m_spDomain, m_gridname.c_str());
-                refine(4);
+                this->start_phase("load domain");
+                this->m_spDomain = make_sp(new TDomain());
+                LoadDomain(*this->m_spDomain, this->m_gridname.c_str());
+                this->stop_phase("load domain");
+
+                this->start_phase("refine");
+                this->refine(this->m_numRefs);
+                this->stop_phase("refine");
 
                 // Approximation Space
-                m_spApproxSpace = make_sp(new TApproxSpace(m_spDomain));
-                m_spApproxSpace->add("c", "Lagrange", 1);
-                m_spApproxSpace->init_top_surface();
+                this->start_phase("approximation space");
+                this->m_spApproxSpace = make_sp(new TApproxSpace(this->m_spDomain));
+                this->m_spApproxSpace->add("c", "Lagrange", 1);
+                this->m_spApproxSpace->init_top_surface();
+                this->stop_phase("approximation space");
 
                 // Element Discretization
                 SmartPtr<TConvDiff> cd = make_sp(new TConvDiff("c", "Inner"));
                 cd->set_diffusion(1.0);
                 cd->set_reaction(0.0);
-                m_spElemDisc = cd;
+                this->m_spElemDisc = cd;
 
                 // Dirichlet Boundary Conditions
                 SmartPtr<TDirichletBoundary> boundary = make_sp(new TDirichletBoundary());
@@ -94,62 +149,64 @@ namespace ug
                 m_spDirichlet = boundary;
                 
                 // Domain Discretization
-                m_spDomainDisc = make_sp(new TDomainDiscretization(m_spApproxSpace));
-                m_spDomainDisc->add(m_spElemDisc);
-                m_spDomainDisc->add(m_spDirichlet);
-
-                // Solver Configuration
-                // Jacobi smoother with default damping of 0.66
-                SmartPtr<Jacobi<TAlgebra>> smoother = make_sp(new Jacobi<TAlgebra>(0.66));
-
-                // Base Solver: SuperLU
-                SmartPtr<ILinearOperatorInverse<vector_type, vector_type>> superlu = make_sp(new SuperLUSolver<TAlgebra>());
-                SmartPtr<AgglomeratingSolver<TAlgebra>> baseSolver = make_sp(new AgglomeratingSolver<TAlgebra>(superlu));
-
-                // Transfer
-                SmartPtr<StdTransfer<TDomain, TAlgebra>> transfer = make_sp(new StdTransfer<TDomain, TAlgebra>());
-                transfer->enable_p1_lagrange_optimization(true);
+                this->m_spDomainDisc = make_sp(new TDomainDiscretization(this->m_spApproxSpace));
+                this->m_spDomainDisc->add(this->m_spElemDisc);
+                this->m_spDomainDisc->add(m_spDirichlet);
 
                 // Geometric Multigrid Preconditioner
-                SmartPtr<GMG> gmg = make_sp(new GMG(m_spApproxSpace));
-                gmg->set_base_solver(baseSolver);
-                gmg->set_smoother(smoother);
-                gmg->set_base_level(0);
-                gmg->set_cycle_type("V");
-                gmg->set_num_presmooth(3);
-                gmg->set_num_postsmooth(3);
-                gmg->set_rap(false);
-                gmg->set_smooth_on_surface_rim(false);
-                gmg->set_emulate_full_refined_grid(false);
-                gmg->set_gathered_base_solver_if_ambiguous(false);
-                gmg->set_transfer(transfer);
+                SmartPtr<GMG> gmg = CreateGMG<TDomain, TAlgebra>(this->m_spApproxSpace, m_gmgSettings);
 
                 // Convergence Check
-                SmartPtr<StdConvCheck<vector_type>> ConvCheck = make_sp(new StdConvCheck<vector_type>(100, 1e-12, 1e-6, true));
+                const number minDefect = 1e-12;
+                const number reduction = 1e-6;
+                SmartPtr<TracedConvCheck<vector_type>> ConvCheck = make_sp(new TracedConvCheck<vector_type>(100, minDefect, reduction, true));
 
-                // BiCGStab Solver
-                m_spSolver = make_sp(new BiCGStab<TAlgebra::vector_type>());
+                // Krylov Solver, BiCGStab by default
+                m_spSolver = CreateKrylovSolver<vector_type>(m_krylovMethod);
                 m_spSolver->set_preconditioner(gmg);
                 m_spSolver->set_convergence_check(ConvCheck);
 
                 // Assemble Linear Operator
-                m_spOp = make_sp(new AssembledLinearOperator<TAlgebra>(m_spDomainDisc));
-                m_spU = make_sp(new TGridFunction(m_spApproxSpace));
-                m_spB = make_sp(new TGridFunction(m_spApproxSpace));
+                m_spOp = make_sp(new AssembledLinearOperator<TAlgebra>(this->m_spDomainDisc));
+                m_spU = make_sp(new TGridFunction(this->m_spApproxSpace));
+                m_spB = make_sp(new TGridFunction(this->m_spApproxSpace));
 
+                this->start_phase("assembly");
                 m_spU->set(0.0);
-                m_spDomainDisc->adjust_solution(*m_spU);
-                m_spDomainDisc->assemble_linear(*m_spOp, *m_spB);
+                this->m_spDomainDisc->adjust_solution(*m_spU);
+                this->m_spDomainDisc->assemble_linear(*m_spOp, *m_spB);
+                this->stop_phase("assembly");
+
+                // the fine solve has to reach the same absolute defect with and without nested
+                // iteration, a reduction of the much smaller nested defect would over-solve
+                const number zeroResidual = this->residual_norm(*m_spOp, *m_spU, *m_spB);
+
+                // Initial Guess
+                if (m_bNestedIteration)
+                {
+                    this->start_phase("nested iteration");
+                    nested_iteration();
+                    this->stop_phase("nested iteration");
+
+                    ConvCheck->set_minimum_defect(std::max(minDefect, reduction * zeroResidual));
+                    ConvCheck->set_reduction(0.0);
+                }
 
                 // Solve
                 SmartPtr<vector_type> u = m_spU;
+                this->start_phase("solver setup");
                 m_spSolver->init(m_spOp, *m_spU);
+                this->stop_phase("solver setup");
+
+                this->start_phase("solve");
                 m_spSolver->apply(*m_spU, *m_spB);
+                this->stop_phase("solve");
+                m_iterations = ConvCheck->step();
+
+                this->record_residual(*m_spOp, *m_spU, *m_spB, zeroResidual, minDefect, reduction);
 
                 // Save Solution
-                SmartPtr<std::vector<double>> sol = make_sp(new std::vector<double>);
-                m_spOp->get_values(*sol);
-                m_spSolution = sol;
+                this->store_solution(*m_spU);
 
                 /*SaveMatrixForConnectionViewer(*m_spU, *m_spOp, "laplace_matrix.mat");
                 SaveVectorForConnectionViewer(*m_spB, "laplace_rhs.vec");
@@ -157,12 +214,178 @@ namespace ug
                 out.print("laplace3d.vtk", *m_spU, true);*/
             }
 
+            /**
+             * Solves the system assembled by run() once more from a zero initial guess with
+             * the given multigrid settings; the solution of run() is not changed.
+             *
+             * \param[in]    settings    multigrid settings
+             * \param[in]    timeLimit   the iteration is stopped as not converged after this
+             *                           many seconds; 0 for no limit
+             * \return iteration count, convergence history, wall clock time and energy of setup and solve
+             */
+            SolveStatistics solve(const GMGSettings &settings, double timeLimit = 0.0)
+            {
+                SmartPtr<HistoryConvCheck<vector_type>> convCheck = make_sp(new HistoryConvCheck<vector_type>(100, 1e-12, 1e-6, false));
+                convCheck->set_time_limit(timeLimit);
+
+                SmartPtr<IPreconditionedLinearOperatorInverse<vector_type>> solver = CreateKrylovSolver<vector_type>(m_krylovMethod);
+                solver->set_preconditioner(CreateGMG<TDomain, TAlgebra>(this->m_spApproxSpace, settings));
+                solver->set_convergence_check(convCheck);
+
+                SmartPtr<TGridFunction> u = m_spU->clone_without_values();
+                u->set(0.0);
+                this->m_spDomainDisc->adjust_solution(*u);
+
+                const RaplCounters &counters = GlobalRaplCounters();
+                SolveStatistics stats;
+                const RaplCounters::reading_type energyStart = counters.read();
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                stats.converged = solver->init(m_spOp, *u) && solver->apply(*u, *m_spB);
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+                stats.seconds = elapsed.count();
+                if (counters.available())
+                    stats.joules = counters.joules(energyStart, counters.read());
+                stats.numDoFs = u->size();
+                stats.iterations = convCheck->step();
+                stats.history = convCheck->history();
+                return stats;
+            }
+
+            /**
+             * \return number of Krylov iterations on the finest level
+             */
+            int num_iterations() const
+            {
+                return m_iterations;
+            }
+
+            /**
+             * \return the discrete solution
+             */
+            SmartPtr<TGridFunction> solution_function() const
+            {
+                return m_spU;
+            }
+
+            /**
+             * Writes the Laplace system assembled on all grid levels, the transfer
+             * matrices between them and the Dirichlet rows to a snapshot file, from
+             * which solver benchmarks can start without grid and discretization.
+             * Has to be called after run().
+             *
+             * \param[in]    filename    name of the snapshot file
+             */
+            void export_snapshot(const std::string &filename)
+            {
+                Snapshot snap;
+                build_snapshot(snap);
+                WriteSnapshot(filename, snap);
+            }
+
+            /**
+             * Assembles the snapshot written by export_snapshot() in memory.
+             * Has to be called after run().
+             *
+             * \param[out]   snap    snapshot
+             */
+            void build_snapshot(Snapshot &snap)
+            {
+                this->m_spApproxSpace->init_levels();
+                const int topLevel = this->m_spApproxSpace->num_levels() - 1;
+
+                SmartPtr<StdTransfer<TDomain, TAlgebra>> transfer = make_sp(new StdTransfer<TDomain, TAlgebra>());
+                transfer->enable_p1_lagrange_optimization(true);
+                transfer->add_constraint(m_spDirichlet);
+
+                snap = Snapshot();
+                for (int lev = 0; lev <= topLevel; lev++)
+                {
+                    const GridLevel gl(lev, GridLevel::LEVEL);
+                    SmartPtr<AssembledLinearOperator<TAlgebra>> A = make_sp(new AssembledLinearOperator<TAlgebra>(this->m_spDomainDisc, gl));
+                    SmartPtr<TGridFunction> b = make_sp(new TGridFunction(this->m_spApproxSpace, gl));
+                    this->m_spDomainDisc->assemble_linear(*A, *b, gl);
+                    snap.levelMatrices.push_back(A);
+
+                    if (lev < topLevel)
+                    {
+                        const GridLevel fineGL(lev + 1, GridLevel::LEVEL);
+                        snap.prolongations.push_back(transfer->prolongation(fineGL, gl, this->m_spApproxSpace));
+                        snap.restrictions.push_back(transfer->restriction(gl, fineGL, this->m_spApproxSpace));
+                        continue;
+                    }
+
+                    SmartPtr<TGridFunction> u = make_sp(new TGridFunction(this->m_spApproxSpace, gl));
+                    u->set(0.0);
+                    this->m_spDomainDisc->adjust_solution(*u, gl);
+                    snap.spB = b;
+                    snap.spU = u;
+                    FindDirichletRows(*A, snap.dirichletRows);
+                }
+            }
+
         protected:
+            /**
+             * Computes the initial guess m_spU by nested iteration. Starting on the base
+             * level, the problem is assembled and solved on the surface of each level with
+             * BiCGStab and GMG down to the base level, and the result is prolongated to
+             * the next finer level.
+             */
+            void nested_iteration()
+            {
+                this->m_spApproxSpace->init_levels();
+                this->m_spApproxSpace->init_surfaces();
+                const int topLevel = this->m_spApproxSpace->num_levels() - 1;
+
+                SmartPtr<StdTransfer<TDomain, TAlgebra>> transfer = make_sp(new StdTransfer<TDomain, TAlgebra>());
+                transfer->enable_p1_lagrange_optimization(true);
+
+                SmartPtr<TracedConvCheck<vector_type>> convCheck = make_sp(new TracedConvCheck<vector_type>(100, 1e-12, 1e-6, false));
+
+                SmartPtr<TGridFunction> uCoarse;
+                for (int lev = 0; lev < topLevel; lev++)
+                {
+                    const GridLevel gl(lev, GridLevel::SURFACE);
+                    SmartPtr<TGridFunction> u = make_sp(new TGridFunction(this->m_spApproxSpace, gl));
+                    SmartPtr<TGridFunction> b = make_sp(new TGridFunction(this->m_spApproxSpace, gl));
+
+                    if (lev == 0)
+                        u->set(0.0);
+                    else
+                        transfer->prolongate(*u, *uCoarse);
+                    this->m_spDomainDisc->adjust_solution(*u, gl);
+
+                    SmartPtr<AssembledLinearOperator<TAlgebra>> op = make_sp(new AssembledLinearOperator<TAlgebra>(this->m_spDomainDisc, gl));
+                    this->m_spDomainDisc->assemble_linear(*op, *b, gl);
+
+                    GMGSettings settings;
+                    settings.surfaceLevel = lev;
+                    BiCGStab<vector_type> solver;
+                    solver.set_preconditioner(CreateGMG<TDomain, TAlgebra>(this->m_spApproxSpace, settings));
+                    solver.set_convergence_check(convCheck);
+
+                    if (!solver.init(op, *u) || !solver.apply(*u, *b))
+                        UG_THROW("Laplace: nested iteration failed on level " << lev << ".");
+
+                    uCoarse = u;
+                }
+
+                if (uCoarse.valid())
+                {
+                    transfer->prolongate(*m_spU, *uCoarse);
+                    this->m_spDomainDisc->adjust_solution(*m_spU);
+                }
+            }
+
             SmartPtr<TDirichletBoundaryBase> m_spDirichlet;
             SmartPtr<AssembledLinearOperator<TAlgebra>> m_spOp;
             SmartPtr<TGridFunction> m_spU;
             SmartPtr<TGridFunction> m_spB;
-            SmartPtr<BiCGStab<TAlgebra::vector_type>> m_spSolver;
+            SmartPtr<IPreconditionedLinearOperatorInverse<vector_type>> m_spSolver;
+            std::string m_krylovMethod;
+            GMGSettings m_gmgSettings;
+            bool m_bNestedIteration;
+            int m_iterations;
         };
 
     } // namespace RegressionTest
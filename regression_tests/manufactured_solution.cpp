@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <string>
+
+#include "ug.h"
+#include "ugbase.h"
+#include "lib_disc/spatial_disc/user_data/std_glob_pos_data.h"
+#include "lib_disc/function_spaces/integrate.h"
+#include "../../ConvectionDiffusion/convection_diffusion_base.h"
+#include "../../ConvectionDiffusion/fv1/convection_diffusion_fv1.h"
+
+#include "testcase.h"
+#include "solver_setup.h"
+#include "convergence_history.h"
+
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Manufactured solution u(x) = Π sin(πx_i) and its derivatives
+         *
+         * Evaluates the solution itself, its value as Dirichlet condition or the
+         * corresponding source term f = -Δu = dim π² u.
+         *
+         * \tparam dim Dimension of the problem
+         * \tparam TRet bool for Dirichlet data, void otherwise
+         */
+        template <int dim, typename TRet>
+        class ManufacturedData : public StdGlobPosData<ManufacturedData<dim, TRet>, number, dim, TRet>
+        {
+        public:
+            /**
+             * \param[in]    source  if true, the source term -Δu is evaluated instead of u
+             */
+            explicit ManufacturedData(bool source = false) : m_bSource(source) {}
+
+            inline TRet evaluate(number &value, const MathVector<dim> &x, number time, int si) const
+            {
+                value = solution(x);
+                if (m_bSource)
+                    value *= dim * PI * PI;
+                // condition flag of Dirichlet data, the value is prescribed everywhere
+                return TRet(true);
+            }
+
+        protected:
+            inline number solution(const MathVector<dim> &x) const
+            {
+                number value = 1.0;
+                for (int d = 0; d < dim; d++)
+                    value *= std::sin(PI * x[d]);
+                return value;
+            }
+
+            bool m_bSource;
+        };
+
+        /**
+         * \brief Method of manufactured solutions testcase
+         *
+         * Solves -Δu = f on the Laplace domain with f and the Dirichlet values of the
+         * manufactured solution Π sin(πx_i) and measures the L2 error of the P1 solution
+         * together with the wall clock time needed for it. Running it on several
+         * refinement levels yields the convergence order and the error-per-cost curve.
+         *
+         * \tparam dim Dimension of the problem
+         */
+        template <int dim>
+        class ManufacturedSolution : public Testcase<dim>
+        {
+            typedef Testcase<dim> base_type;
+            typedef typename base_type::TAlgebra TAlgebra;
+            typedef typename base_type::vector_type vector_type;
+            typedef typename base_type::TDomain TDomain;
+            typedef typename base_type::TApproxSpace TApproxSpace;
+            typedef typename base_type::TDirichletBoundary TDirichletBoundary;
+            typedef typename base_type::TDomainDiscretization TDomainDiscretization;
+            typedef typename base_type::TGridFunction TGridFunction;
+            typedef ug::ConvectionDiffusionPlugin::ConvectionDiffusionFV1<TDomain> TConvDiff;
+            typedef ug::AssembledMultiGridCycle<TDomain, TAlgebra> GMG;
+
+        public:
+            /**
+             * Constructor, the testcase is checked against the exact solution and has no
+             * reference file
+             *
+             * \param[in]    grid    Name of the grid file
+             */
+            explicit ManufacturedSolution(std::string grid)
+                : base_type(grid, ""), m_l2Error(0.0), m_seconds(0.0), m_numDoFs(0)
+            {
+            }
+
+            /**
+             * Runs the manufactured solution testcase
+             */
+            void run()
+            {
+                AlgebraType algebra("CPU", 1);
+                ug::bridge::InitUG(dim, algebra);
+
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+                // Domain
+                this->m_spDomain = make_sp(new TDomain());
+                LoadDomain(*this->m_spDomain, this->m_gridname.c_str());
+                this->refine(this->m_numRefs);
+
+                // Approximation Space
+                this->m_spApproxSpace = make_sp(new TApproxSpace(this->m_spDomain));
+                this->m_spApproxSpace->add("c", "Lagrange", 1);
+                this->m_spApproxSpace->init_top_surface();
+
+                // Element Discretization with the manufactured source
+                SmartPtr<TConvDiff> cd = make_sp(new TConvDiff("c", "Inner"));
+                cd->set_diffusion(1.0);
+                cd->set_reaction(0.0);
+                cd->set_source(make_sp(new ManufacturedData<dim, void>(true)));
+                this->m_spElemDisc = cd;
+
+                // Dirichlet Boundary Conditions: the manufactured solution
+                SmartPtr<TDirichletBoundary> boundary = make_sp(new TDirichletBoundary());
+                boundary->add(make_sp(new ManufacturedData<dim, bool>()), "c", "bndNegative,bndPositive");
+
+                // Domain Discretization
+                this->m_spDomainDisc = make_sp(new TDomainDiscretization(this->m_spApproxSpace));
+                this->m_spDomainDisc->add(this->m_spElemDisc);
+                this->m_spDomainDisc->add(boundary);
+
+                // BiCGStab with GMG, converged well below the discretization error
+                SmartPtr<GMG> gmg = CreateGMG<TDomain, TAlgebra>(this->m_spApproxSpace);
+                SmartPtr<TracedConvCheck<vector_type>> convCheck = make_sp(new TracedConvCheck<vector_type>(100, 1e-14, 1e-10, false));
+                BiCGStab<vector_type> solver;
+                solver.set_preconditioner(gmg);
+                solver.set_convergence_check(convCheck);
+
+                // Assemble and Solve
+                SmartPtr<AssembledLinearOperator<TAlgebra>> op = make_sp(new AssembledLinearOperator<TAlgebra>(this->m_spDomainDisc));
+                SmartPtr<TGridFunction> u = make_sp(new TGridFunction(this->m_spApproxSpace));
+                SmartPtr<TGridFunction> b = make_sp(new TGridFunction(this->m_spApproxSpace));
+
+                u->set(0.0);
+                this->m_spDomainDisc->adjust_solution(*u);
+                this->m_spDomainDisc->assemble_linear(*op, *b);
+
+                if (!solver.init(op, *u) || !solver.apply(*u, *b))
+                    UG_THROW("ManufacturedSolution: BiCGStab did not converge.");
+
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                m_seconds = elapsed.count();
+                m_numDoFs = u->size();
+
+                // Discretization Error
+                m_l2Error = L2Error<TGridFunction>(make_sp(new ManufacturedData<dim, void>()), u, "c", 0.0, 4);
+
+                this->store_solution(*u);
+            }
+
+            /**
+             * \return L2 error of the discrete solution
+             */
+            number l2_error() const
+            {
+                return m_l2Error;
+            }
+
+            /**
+             * \return wall clock time from loading the grid to the solution
+             */
+            double seconds() const
+            {
+                return m_seconds;
+            }
+
+            /**
+             * \return number of DoFs
+             */
+            size_t num_dofs() const
+            {
+                return m_numDoFs;
+            }
+
+        protected:
+            number m_l2Error;
+            double m_seconds;
+            size_t m_numDoFs;
+        };
+
+    } // namespace RegressionTest
+} // namespace ug
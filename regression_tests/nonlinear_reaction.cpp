@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "ug.h"
+#include "ugbase.h"
+#include "lib_disc/spatial_disc/user_data/linker/scale_add_linker.h"
+#include "../../ConvectionDiffusion/convection_diffusion_base.h"
+#include "../../ConvectionDiffusion/fv1/convection_diffusion_fv1.h"
+
+#include "testcase.h"
+#include "solver_setup.h"
+#include "convergence_history.h"
+
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Nonlinear reaction-diffusion testcase
+         *
+         * Solves -Δc + c³ = 0 on the Laplace domain with a damped Newton method. The
+         * cubic reaction is linked to the unknown, so the Jacobian is assembled by the
+         * FV1 discretization. The Newton loop is written out here instead of using
+         * NewtonSolver, so that the time spent in defect assembly, Jacobian assembly,
+         * linear solve (including the GMG setup) and line search can be measured
+         * separately. The line search phase contains the defect assemblies it triggers.
+         *
+         * \tparam dim Dimension of the problem
+         */
+        template <int dim>
+        class NonlinearReaction : public Testcase<dim>
+        {
+            typedef Testcase<dim> base_type;
+            typedef typename base_type::TAlgebra TAlgebra;
+            typedef typename base_type::vector_type vector_type;
+            typedef typename base_type::TDomain TDomain;
+            typedef typename base_type::TApproxSpace TApproxSpace;
+            typedef typename base_type::TDirichletBoundary TDirichletBoundary;
+            typedef typename base_type::TDomainDiscretization TDomainDiscretization;
+            typedef typename base_type::TGridFunction TGridFunction;
+            typedef ug::ConvectionDiffusionPlugin::ConvectionDiffusionFV1<TDomain> TConvDiff;
+            typedef ug::AssembledMultiGridCycle<TDomain, TAlgebra> GMG;
+            typedef ScaleAddLinker<number, dim, number> TLinker;
+
+        public:
+            /**
+             * Constructor
+             *
+             * \param[in]    grid        Name of the grid file
+             * \param[in]    reference   Name of the reference file
+             */
+            NonlinearReaction(std::string grid, std::string reference)
+                : base_type(grid, reference), m_maxSteps(20), m_absTol(1e-10), m_redTol(1e-8)
+            {
+            }
+
+            /**
+             * sets the file of the reference Newton defect history
+             *
+             * \param[in]    reference   Name of the reference file
+             */
+            void set_history_reference(std::string reference)
+            {
+                m_historyReference = reference;
+            }
+
+            /**
+             * Runs the nonlinear reaction-diffusion testcase
+             */
+            void run()
+            {
+                AlgebraType algebra("CPU", 1);
+                ug::bridge::InitUG(dim, algebra);
+
+                // Domain
+                this->m_spDomain = make_sp(new TDomain());
+                LoadDomain(*this->m_spDomain, this->m_gridname.c_str());
+                this->refine(this->m_numRefs);
+
+                // Approximation Space
+                this->m_spApproxSpace = make_sp(new TApproxSpace(this->m_spDomain));
+                this->m_spApproxSpace->add("c", "Lagrange", 1);
+                this->m_spApproxSpace->init_top_surface();
+
+                // Element Discretization with reaction c³ linked to the unknown
+                SmartPtr<TConvDiff> cd = make_sp(new TConvDiff("c", "Inner"));
+                cd->set_diffusion(1.0);
+
+                SmartPtr<TLinker> square = make_sp(new TLinker());
+                square->add(cd->value(), cd->value());
+                SmartPtr<TLinker> cube = make_sp(new TLinker());
+                cube->add(square, cd->value());
+                cd->set_reaction(cube);
+                this->m_spElemDisc = cd;
+
+                // Dirichlet Boundary Conditions
+                SmartPtr<TDirichletBoundary> boundary = make_sp(new TDirichletBoundary());
+                boundary->add(-1, "c", "bndNegative");
+                boundary->add(1, "c", "bndPositive");
+
+                // Domain Discretization
+                this->m_spDomainDisc = make_sp(new TDomainDiscretization(this->m_spApproxSpace));
+                this->m_spDomainDisc->add(this->m_spElemDisc);
+                this->m_spDomainDisc->add(boundary);
+
+                // Linear Solver: BiCGStab with GMG
+                SmartPtr<GMG> gmg = CreateGMG<TDomain, TAlgebra>(this->m_spApproxSpace);
+                SmartPtr<TracedConvCheck<vector_type>> convCheck = make_sp(new TracedConvCheck<vector_type>(100, 1e-12, 1e-6, false));
+                SmartPtr<BiCGStab<vector_type>> solver = make_sp(new BiCGStab<vector_type>());
+                solver->set_preconditioner(gmg);
+                solver->set_convergence_check(convCheck);
+
+                // Vectors
+                SmartPtr<AssembledLinearOperator<TAlgebra>> J = make_sp(new AssembledLinearOperator<TAlgebra>(this->m_spDomainDisc));
+                m_spU = make_sp(new TGridFunction(this->m_spApproxSpace));
+                SmartPtr<TGridFunction> d = m_spU->clone_without_values();
+                SmartPtr<TGridFunction> c = m_spU->clone_without_values();
+                SmartPtr<TGridFunction> uTrial = m_spU->clone_without_values();
+
+                m_spU->set(0.0);
+                this->m_spDomainDisc->adjust_solution(*m_spU);
+
+                this->start_phase("defect assembly");
+                this->m_spDomainDisc->assemble_defect(*d, *m_spU);
+                this->stop_phase("defect assembly");
+
+                // Newton Iteration
+                m_history.clear();
+                m_linearIterations.clear();
+                number defect = d->norm();
+                const number initialDefect = defect;
+                m_history.push_back(defect);
+
+                for (int step = 0; step < m_maxSteps; step++)
+                {
+                    if (defect < m_absTol || defect < m_redTol * initialDefect)
+                        break;
+
+                    this->start_phase("jacobian assembly");
+                    this->m_spDomainDisc->assemble_jacobian(*J, *m_spU);
+                    this->stop_phase("jacobian assembly");
+
+                    this->start_phase("linear solve");
+                    c->set(0.0);
+                    solver->init(J, *m_spU);
+                    if (!solver->apply(*c, *d))
+                        UG_THROW("NonlinearReaction: linear solver failed in Newton step " << step << ".");
+                    this->stop_phase("linear solve");
+                    m_linearIterations.push_back(convCheck->step());
+
+                    this->start_phase("line search");
+                    defect = line_search(*c, *uTrial, *d, defect);
+                    this->stop_phase("line search");
+
+                    m_history.push_back(defect);
+                }
+
+                if (!(defect < m_absTol || defect < m_redTol * initialDefect))
+                    UG_THROW("NonlinearReaction: Newton method did not converge in " << m_maxSteps << " steps.");
+
+                // Save Solution
+                this->store_solution(*m_spU);
+            }
+
+            /**
+             * \return defect norms of all Newton steps, starting with the initial defect
+             */
+            const std::vector<double> &history() const
+            {
+                return m_history;
+            }
+
+            /**
+             * \return number of linear iterations in each Newton step
+             */
+            const std::vector<int> &linear_iterations() const
+            {
+                return m_linearIterations;
+            }
+
+            /**
+             * \return true if the reference history exists
+             */
+            bool has_history_reference() const
+            {
+                std::ifstream is(m_historyReference);
+                return is.good();
+            }
+
+            /**
+             * writes the current Newton history as new reference
+             */
+            void save_history_reference()
+            {
+                this->write_values(m_historyReference, m_history);
+            }
+
+            /**
+             * Compares the Newton defect history with the reference history. With
+             * --update-references the current history is written as reference first.
+             *
+             * The number of Newton steps has to match exactly, the defects up to a
+             * relative tolerance of 1e-4 (defects below the absolute tolerance are not
+             * compared, they are dominated by round-off).
+             *
+             * \return true if the history is equal to the reference history
+             */
+            bool compare_history()
+            {
+                if (UpdateReferences())
+                    save_history_reference();
+
+                if (!has_history_reference())
+                {
+                    std::cout << "Reference " << m_historyReference << " does not exist, generate it with"
+                              << " ug4tests --update-references" << std::endl;
+                    return false;
+                }
+
+                SmartPtr<std::vector<double>> reference = this->read_values(m_historyReference);
+
+                if (reference->size() != m_history.size())
+                {
+                    std::cout << "Newton steps: " << m_history.size() - 1 << ", reference: "
+                              << (reference->empty() ? 0 : reference->size() - 1) << std::endl;
+                    return false;
+                }
+
+                for (size_t i = 0; i < m_history.size(); i++)
+                {
+                    if ((*reference)[i] < m_absTol && m_history[i] < m_absTol)
+                        continue;
+
+                    if (std::abs(m_history[i] - (*reference)[i]) > 1e-4 * (*reference)[i])
+                    {
+                        std::cout << "Newton defect not equal at step " << i << std::endl;
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+
+        protected:
+            /**
+             * backtracking line search along the Newton correction
+             *
+             * Accepts u - λc for the first λ = 1, 1/2, ..., 1/512 that sufficiently
+             * reduces the defect and throws if none does, the Newton method has failed then.
+             * On return m_spU holds the new iterate and d its defect.
+             *
+             * \param[in]    c           Newton correction
+             * \param[in]    uTrial      work vector
+             * \param[in,out] d          defect
+             * \param[in]    defect      norm of the current defect
+             * \return norm of the new defect
+             */
+            number line_search(const vector_type &c, vector_type &uTrial, vector_type &d, number defect)
+            {
+                number lambda = 1.0;
+
+                for (int i = 0; i < 10; i++)
+                {
+                    VecScaleAdd(uTrial, 1.0, *m_spU, -lambda, c);
+
+                    this->start_phase("defect assembly");
+                    this->m_spDomainDisc->assemble_defect(d, uTrial);
+                    this->stop_phase("defect assembly");
+
+                    const number trialDefect = d.norm();
+                    if (trialDefect <= (1.0 - 0.25 * lambda) * defect)
+                    {
+                        VecScaleAssign(*m_spU, 1.0, uTrial);
+                        return trialDefect;
+                    }
+
+                    lambda *= 0.5;
+                }
+
+                UG_THROW("NonlinearReaction: line search found no sufficient decrease of the defect " << defect << ".");
+            }
+
+            SmartPtr<TGridFunction> m_spU;
+            std::vector<double> m_history;
+            std::vector<int> m_linearIterations;
+            std::string m_historyReference;
+            int m_maxSteps;
+            number m_absTol;
+            number m_redTol;
+        };
+
+    } // namespace RegressionTest
+} // namespace ug
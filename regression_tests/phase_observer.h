@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef UG4TESTS_REGRESSION_TESTS_PHASE_OBSERVER_H
+#define UG4TESTS_REGRESSION_TESTS_PHASE_OBSERVER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Interface for tools that follow the phases of the testcases
+         *
+         * Observers are registered once in main, before the tests run, and are notified
+         * by Testcase::start_phase and Testcase::stop_phase as well as by the
+         * BenchmarkRunner for every finished benchmark. Spans are finer grained regions,
+         * e.g. a refinement level or a solver iteration, that are not accumulated in the
+         * timings of the testcase; they may be started and stopped by any thread.
+         */
+        class PhaseObserver
+        {
+        public:
+            virtual ~PhaseObserver() {}
+
+            /**
+             * \param[in] phase  name of the phase that starts
+             */
+            virtual void phase_started(const std::string & /*phase*/) {}
+
+            /**
+             * \param[in] phase      name of the phase that ended
+             * \param[in] seconds    wall clock time of the phase
+             */
+            virtual void phase_stopped(const std::string & /*phase*/, double /*seconds*/) {}
+
+            /**
+             * \param[in] name   name of the measured quantity
+             * \param[in] value  measured value
+             */
+            virtual void metric_recorded(const std::string & /*name*/, double /*value*/) {}
+
+            /**
+             * \param[in] name   name of the span that starts on the calling thread
+             */
+            virtual void span_started(const std::string & /*name*/) {}
+
+            /**
+             * \param[in] name   name of the span that ends on the calling thread
+             */
+            virtual void span_stopped(const std::string & /*name*/) {}
+
+            /**
+             * \param[in] numDoFs    number of degrees of freedom of the testcase
+             */
+            virtual void problem_size(size_t /*numDoFs*/) {}
+
+            /**
+             * \return true if the observer wants the spans of every smoother and base solver
+             *         call, which the solver setup only installs on request as they cost
+             *         time on every multigrid cycle
+             */
+            virtual bool wants_solver_spans() const { return false; }
+        };
+
+        /**
+         * \return registered phase observers
+         */
+        inline std::vector<PhaseObserver *> &PhaseObservers()
+        {
+            static std::vector<PhaseObserver *> observers;
+            return observers;
+        }
+
+        /**
+         * registers an observer, the caller keeps the ownership and has to unregister
+         * it before destroying it; gtest listeners register in OnTestProgramStart and
+         * unregister in OnTestProgramEnd, as the registry may already be destroyed when
+         * gtest deletes its listeners at exit
+         */
+        inline void AddPhaseObserver(PhaseObserver *observer)
+        {
+            PhaseObservers().push_back(observer);
+        }
+
+        /**
+         * unregisters an observer
+         */
+        inline void RemovePhaseObserver(PhaseObserver *observer)
+        {
+            std::vector<PhaseObserver *> &observers = PhaseObservers();
+            observers.erase(std::remove(observers.begin(), observers.end(), observer), observers.end());
+        }
+
+        /**
+         * \return true if a registered observer wants the spans of the solver calls
+         */
+        inline bool SolverSpansRequested()
+        {
+            for (PhaseObserver *observer : PhaseObservers())
+                if (observer->wants_solver_spans())
+                    return true;
+            return false;
+        }
+
+        inline void NotifyPhaseStarted(const std::string &phase)
+        {
+            for (PhaseObserver *observer : PhaseObservers())
+                observer->phase_started(phase);
+        }
+
+        inline void NotifyPhaseStopped(const std::string &phase, double seconds)
+        {
+            for (PhaseObserver *observer : PhaseObservers())
+                observer->phase_stopped(phase, seconds);
+        }
+
+        inline void NotifyMetric(const std::string &name, double value)
+        {
+            for (PhaseObserver *observer : PhaseObservers())
+                observer->metric_recorded(name, value);
+        }
+
+        inline void NotifySpanStarted(const std::string &name)
+        {
+            for (PhaseObserver *observer : PhaseObservers())
+                observer->span_started(name);
+        }
+
+        inline void NotifySpanStopped(const std::string &name)
+        {
+            for (PhaseObserver *observer : PhaseObservers())
+                observer->span_stopped(name);
+        }
+
+        inline void NotifyProblemSize(size_t numDoFs)
+        {
+            for (PhaseObserver *observer : PhaseObservers())
+                observer->problem_size(numDoFs);
+        }
+
+        /**
+         * \brief Span lasting for the lifetime of the object
+         */
+        class ScopedSpan
+        {
+        public:
+            explicit ScopedSpan(const std::string &name) : m_name(name)
+            {
+                NotifySpanStarted(m_name);
+            }
+
+            ~ScopedSpan()
+            {
+                NotifySpanStopped(m_name);
+            }
+
+        private:
+            ScopedSpan(const ScopedSpan &);
+            ScopedSpan &operator=(const ScopedSpan &);
+
+            std::string m_name;
+        };
+
+        /**
+         * \brief Parses and removes a flag from the command line
+         *
+         * \param[in] flag    e.g. "--profile"
+         * \return true if the flag is given
+         */
+        inline bool ParseFlagOption(int &argc, char **argv, const std::string &flag)
+        {
+            bool found = false;
+            int kept = 1;
+            for (int i = 1; i < argc; i++)
+            {
+                if (flag == argv[i])
+                    found = true;
+                else
+                    argv[kept++] = argv[i];
+            }
+            argc = kept;
+            argv[argc] = nullptr;
+            return found;
+        }
+
+        /**
+         * \brief Parses and removes an option of the form <prefix><value> from the command line
+         *
+         * \param[in] prefix  e.g. "--history="
+         * \return value of the option, empty if the option is not given
+         */
+        inline std::string ParseValueOption(int &argc, char **argv, const std::string &prefix)
+        {
+            std::string value;
+            int kept = 1;
+            for (int i = 1; i < argc; i++)
+            {
+                const std::string arg = argv[i];
+                if (arg.compare(0, prefix.size(), prefix) == 0)
+                    value = arg.substr(prefix.size());
+                else
+                    argv[kept++] = argv[i];
+            }
+            argc = kept;
+            argv[argc] = nullptr;
+            return value;
+        }
+
+    } // namespace RegressionTest
+} // namespace ug
+
+#endif /* UG4TESTS_REGRESSION_TESTS_PHASE_OBSERVER_H */
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef UG4TESTS_REGRESSION_TESTS_PIPELINED_BICGSTAB_H
+#define UG4TESTS_REGRESSION_TESTS_PIPELINED_BICGSTAB_H
+
+#include <cmath>
+
+#include "ug.h"
+#include "ugbase.h"
+#include "lib_algebra/operator/interface/preconditioned_linear_operator_inverse.h"
+
+#include "fused_kernels.h"
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Pipelined, preconditioned BiCGStab
+         *
+         * Communication hiding BiCGStab variant of Cools and Vanroose ("The
+         * communication-hiding pipelined BiCGStab method for the parallel solution of
+         * large unsymmetric linear systems", Parallel Computing 65, 2017). Each iteration
+         * has two global synchronization points instead of the four to five blocking
+         * reductions of BiCGStab. All dot products of a synchronization point are
+         * computed in one pass over the vectors and reduced together, overlapped with a
+         * preconditioner application and a matrix-vector product. The price are more
+         * vector updates per iteration and a slightly different rounding behaviour.
+         *
+         * In parallel, results of the operator are made unique so that dot products of
+         * unhatted vectors can be summed locally; preconditioned (hatted) vectors are
+         * consistent. Only scalar algebras are supported.
+         *
+         * \tparam TVector vector type
+         */
+        template <typename TVector>
+        class PipelinedBiCGStab : public IPreconditionedLinearOperatorInverse<TVector>
+        {
+        public:
+            typedef TVector vector_type;
+            typedef IPreconditionedLinearOperatorInverse<TVector> base_type;
+
+            using base_type::convergence_check;
+            using base_type::linear_operator;
+            using base_type::preconditioner;
+
+            virtual const char *name() const { return "PipelinedBiCGStab"; }
+
+            virtual bool supports_parallel() const
+            {
+                if (preconditioner().valid())
+                    return preconditioner()->supports_parallel();
+                return true;
+            }
+
+            virtual bool apply_return_defect(vector_type &x, vector_type &b)
+            {
+                #ifdef UG_PARALLEL
+                if (!b.has_storage_type(PST_ADDITIVE) || !x.has_storage_type(PST_CONSISTENT))
+                    UG_THROW("PipelinedBiCGStab: Inadequate storage format of vectors.");
+                #endif
+
+                SmartPtr<vector_type> spR = b.clone_without_values();
+                vector_type &r = *spR;
+                SmartPtr<vector_type> spRStar = b.clone_without_values(), spRHat = x.clone_without_values();
+                SmartPtr<vector_type> spW = b.clone_without_values(), spWHat = x.clone_without_values();
+                SmartPtr<vector_type> spT = b.clone_without_values(), spV = b.clone_without_values();
+                SmartPtr<vector_type> spS = b.clone_without_values(), spSHat = x.clone_without_values();
+                SmartPtr<vector_type> spZ = b.clone_without_values(), spZHat = x.clone_without_values();
+                SmartPtr<vector_type> spPHat = x.clone_without_values();
+                SmartPtr<vector_type> spQ = b.clone_without_values(), spQHat = x.clone_without_values();
+                SmartPtr<vector_type> spY = b.clone_without_values(), spTmp = x.clone_without_values();
+                vector_type &rStar = *spRStar, &rHat = *spRHat, &w = *spW, &wHat = *spWHat, &t = *spT, &v = *spV;
+                vector_type &s = *spS, &sHat = *spSHat, &z = *spZ, &zHat = *spZHat, &pHat = *spPHat;
+                vector_type &q = *spQ, &qHat = *spQHat, &y = *spY, &tmp = *spTmp;
+
+                // r = b - Ax, w = A M^-1 r, t = A M^-1 w
+                VecScaleAssign(r, 1.0, b);
+                linear_operator()->apply_sub(r, x);
+                make_unique(r);
+                VecScaleAssign(rStar, 1.0, r);
+
+                precondition(rHat, r);
+                linear_operator()->apply(w, rHat);
+                make_unique(w);
+                precondition(wHat, w);
+                linear_operator()->apply(t, wHat);
+                make_unique(t);
+
+                ReductionBatch init(3);
+                FusedVecProd(rStar, r, rStar, w, r, r, init.local(0), init.local(1), init.local(2));
+                init.reduce();
+
+                convergence_check()->set_symbol('%');
+                convergence_check()->set_name(name());
+                convergence_check()->start_defect(std::sqrt(init.global(2)));
+
+                number rho = init.global(0);
+                number alpha = rho / init.global(1);
+                number beta = 0.0;
+                number omega = 0.0;
+
+                ReductionBatch red1(2);
+                ReductionBatch red2(5);
+
+                for (bool first = true; !convergence_check()->iteration_ended(); first = false)
+                {
+                    if (first)
+                    {
+                        VecScaleAssign(pHat, 1.0, rHat);
+                        VecScaleAssign(s, 1.0, w);
+                        VecScaleAssign(sHat, 1.0, wHat);
+                        VecScaleAssign(z, 1.0, t);
+                    }
+                    else
+                    {
+                        VecScaleAdd(pHat, 1.0, rHat, beta, pHat, -beta * omega, sHat);
+                        VecScaleAdd(s, 1.0, w, beta, s, -beta * omega, z);
+                        VecScaleAdd(sHat, 1.0, wHat, beta, sHat, -beta * omega, zHat);
+                        VecScaleAdd(z, 1.0, t, beta, z, -beta * omega, v);
+                    }
+
+                    VecScaleAdd(q, 1.0, r, -alpha, s);
+                    VecScaleAdd(qHat, 1.0, rHat, -alpha, sHat);
+                    VecScaleAdd(y, 1.0, w, -alpha, z);
+
+                    // first synchronization point, hidden behind zHat = M^-1 z, v = A zHat
+                    FusedVecProd(q, y, y, y, red1.local(0), red1.local(1));
+                    red1.start();
+                    precondition(zHat, z);
+                    linear_operator()->apply(v, zHat);
+                    make_unique(v);
+                    red1.wait();
+
+                    if (red1.global(1) == 0.0)
+                    {
+                        // y = 0: the residual q is already the final one
+                        VecScaleAdd(x, 1.0, x, alpha, pHat);
+                        VecScaleAssign(r, 1.0, q);
+                        convergence_check()->update(r);
+                        break;
+                    }
+                    omega = red1.global(0) / red1.global(1);
+
+                    VecScaleAdd(x, 1.0, x, alpha, pHat, omega, qHat);
+                    VecScaleAdd(r, 1.0, q, -omega, y);
+                    VecScaleAdd(tmp, 1.0, wHat, -alpha, zHat);
+                    VecScaleAdd(rHat, 1.0, qHat, -omega, tmp);
+                    VecScaleAdd(w, 1.0, y, -omega, t, alpha * omega, v);
+
+                    // second synchronization point, hidden behind wHat = M^-1 w, t = A wHat
+                    FusedVecProd(rStar, r, rStar, w, rStar, s, rStar, z, r, r,
+                                 red2.local(0), red2.local(1), red2.local(2), red2.local(3), red2.local(4));
+                    red2.start();
+                    precondition(wHat, w);
+                    linear_operator()->apply(t, wHat);
+                    make_unique(t);
+                    red2.wait();
+
+                    convergence_check()->update_defect(std::sqrt(red2.global(4)));
+                    if (omega == 0.0 || rho == 0.0)
+                        break;
+
+                    const number rhoNew = red2.global(0);
+                    beta = (alpha / omega) * (rhoNew / rho);
+                    alpha = rhoNew / (red2.global(1) + beta * red2.global(2) - beta * omega * red2.global(3));
+                    rho = rhoNew;
+                }
+
+                VecScaleAssign(b, 1.0, r);
+                return convergence_check()->post();
+            }
+
+        protected:
+            /// c = M^-1 d, or c = d without preconditioner
+            void precondition(vector_type &c, const vector_type &d)
+            {
+                if (preconditioner().valid())
+                {
+                    if (!preconditioner()->apply(c, d))
+                        UG_THROW("PipelinedBiCGStab: preconditioner failed.");
+                    return;
+                }
+
+                VecScaleAssign(c, 1.0, d);
+                #ifdef UG_PARALLEL
+                c.change_storage_type(PST_CONSISTENT);
+                #endif
+            }
+
+            /// makes additive vectors unique, so their local dot products can be summed
+            void make_unique(vector_type &v)
+            {
+                #ifdef UG_PARALLEL
+                v.change_storage_type(PST_UNIQUE);
+                #endif
+            }
+        };
+
+    } // namespace RegressionTest
+} // namespace ug
+
+#endif /* UG4TESTS_REGRESSION_TESTS_PIPELINED_BICGSTAB_H */
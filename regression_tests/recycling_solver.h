@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef UG4TESTS_REGRESSION_TESTS_RECYCLING_SOLVER_H
+#define UG4TESTS_REGRESSION_TESTS_RECYCLING_SOLVER_H
+
+#include <cmath>
+#include <deque>
+
+#include "ug.h"
+#include "ugbase.h"
+#include "lib_algebra/operator/interface/preconditioned_linear_operator_inverse.h"
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Preconditioned GCR with Krylov subspace recycling across solves
+         *
+         * Augmented Krylov method in the GCRO family (de Sturler, "Nested Krylov methods
+         * based on GCR", J. Comput. Appl. Math. 67, 1996; Parks et al., "Recycling Krylov
+         * subspaces for sequences of linear systems", SIAM J. Sci. Comput. 28, 2006). The
+         * solver keeps a recycled space U with C = A U, C orthonormal. Every solve first
+         * removes the part of the defect in range(C), x += U C^T r, r -= C C^T r, and then
+         * runs right preconditioned GCR on the deflated operator (I - C C^T) A M^-1: each
+         * new direction z = M^-1 r is orthogonalized, through q = A z, against C and the
+         * directions of the current solve, so the residual is minimized over the recycled
+         * and the new Krylov space together. Only the last maxDirections directions of a
+         * solve are kept (truncated GCR). After a solve its remaining directions, which
+         * approximate the slowly converging part of A M^-1, are added to U; the oldest
+         * recycled directions are dropped beyond maxVectors. Unlike GCRO-DR, which
+         * selects harmonic Ritz vectors, the space is selected by recency.
+         *
+         * The space is cleared when the solver is initialized with another operator.
+         * Without recycled vectors (maxVectors = 0) this is plain truncated GCR. Serial
+         * only; residual and images are kept consistent.
+         *
+         * \tparam TVector vector type
+         */
+        template <typename TVector>
+        class RecyclingSolver : public IPreconditionedLinearOperatorInverse<TVector>
+        {
+        public:
+            typedef TVector vector_type;
+            typedef IPreconditionedLinearOperatorInverse<TVector> base_type;
+
+            using base_type::convergence_check;
+            using base_type::linear_operator;
+            using base_type::preconditioner;
+
+            /**
+             * \param[in]    maxVectors      maximum number of recycled directions, the oldest are dropped
+             * \param[in]    maxDirections   directions of a solve kept for orthogonalization
+             */
+            explicit RecyclingSolver(size_t maxVectors = 20, size_t maxDirections = 30)
+                : m_maxVectors(maxVectors), m_maxDirections(maxDirections)
+            {
+            }
+
+            virtual const char *name() const { return "RecyclingSolver"; }
+
+            virtual bool supports_parallel() const { return false; }
+
+            virtual bool init(SmartPtr<ILinearOperator<vector_type>> L)
+            {
+                if (L.get() != linear_operator().get())
+                    clear();
+                return base_type::init(L);
+            }
+
+            virtual bool init(SmartPtr<ILinearOperator<vector_type>> J, const vector_type &u)
+            {
+                if (J.get() != linear_operator().get())
+                    clear();
+                return base_type::init(J, u);
+            }
+
+            virtual bool apply_return_defect(vector_type &x, vector_type &b)
+            {
+                // r = b - Ax, projected onto the complement of range(C)
+                SmartPtr<vector_type> spR = b.clone_without_values();
+                vector_type &r = *spR;
+                VecScaleAssign(r, 1.0, b);
+                linear_operator()->apply_sub(r, x);
+                #ifdef UG_PARALLEL
+                r.change_storage_type(PST_CONSISTENT);
+                #endif
+                for (size_t i = 0; i < m_spC.size(); i++)
+                {
+                    const number alpha = VecProd(*m_spC[i], r);
+                    VecScaleAdd(x, 1.0, x, alpha, *m_spU[i]);
+                    VecScaleAdd(r, 1.0, r, -alpha, *m_spC[i]);
+                }
+
+                convergence_check()->set_symbol('%');
+                convergence_check()->set_name(name());
+                convergence_check()->start(r);
+
+                std::deque<SmartPtr<vector_type>> spZ, spQ;
+                while (!convergence_check()->iteration_ended())
+                {
+                    // z = M^-1 r, q = A z
+                    SmartPtr<vector_type> z = x.clone_without_values();
+                    SmartPtr<vector_type> q = b.clone_without_values();
+                    precondition(*z, r);
+                    linear_operator()->apply(*q, *z);
+                    #ifdef UG_PARALLEL
+                    q->change_storage_type(PST_CONSISTENT);
+                    #endif
+
+                    // orthogonalize q against the recycled and the current directions
+                    orthogonalize(*z, *q, m_spU, m_spC);
+                    orthogonalize(*z, *q, spZ, spQ);
+                    const number norm = q->norm();
+                    if (norm == 0.0)
+                        break;
+                    VecScaleAssign(*z, 1.0 / norm, *z);
+                    VecScaleAssign(*q, 1.0 / norm, *q);
+
+                    // minimal residual step along q
+                    const number alpha = VecProd(*q, r);
+                    VecScaleAdd(x, 1.0, x, alpha, *z);
+                    VecScaleAdd(r, 1.0, r, -alpha, *q);
+                    convergence_check()->update(r);
+
+                    spZ.push_back(z);
+                    spQ.push_back(q);
+                    if (spZ.size() > m_maxDirections)
+                    {
+                        spZ.pop_front();
+                        spQ.pop_front();
+                    }
+                }
+
+                // the remaining directions are orthonormal to each other and to C
+                for (size_t i = 0; i < spZ.size() && m_maxVectors > 0; i++)
+                {
+                    m_spU.push_back(spZ[i]);
+                    m_spC.push_back(spQ[i]);
+                    if (m_spU.size() > m_maxVectors)
+                    {
+                        m_spU.pop_front();
+                        m_spC.pop_front();
+                    }
+                }
+
+                VecScaleAssign(b, 1.0, r);
+                return convergence_check()->post();
+            }
+
+            /**
+             * \return number of recycled directions
+             */
+            size_t num_vectors() const
+            {
+                return m_spU.size();
+            }
+
+            /**
+             * removes all recycled directions
+             */
+            void clear()
+            {
+                m_spU.clear();
+                m_spC.clear();
+            }
+
+        protected:
+            /// c = M^-1 d, or c = d without preconditioner
+            void precondition(vector_type &c, const vector_type &d)
+            {
+                if (preconditioner().valid())
+                {
+                    if (!preconditioner()->apply(c, d))
+                        UG_THROW("RecyclingSolver: preconditioner failed.");
+                    return;
+                }
+                VecScaleAssign(c, 1.0, d);
+            }
+
+            /// modified Gram-Schmidt of q against the orthonormal c_i, the same combination on z and the u_i
+            void orthogonalize(vector_type &z, vector_type &q, const std::deque<SmartPtr<vector_type>> &spU,
+                               const std::deque<SmartPtr<vector_type>> &spC) const
+            {
+                for (size_t i = 0; i < spC.size(); i++)
+                {
+                    const number beta = VecProd(*spC[i], q);
+                    VecScaleAdd(q, 1.0, q, -beta, *spC[i]);
+                    VecScaleAdd(z, 1.0, z, -beta, *spU[i]);
+                }
+            }
+
+            size_t m_maxVectors;
+            size_t m_maxDirections;
+            /// recycled directions u_i and their orthonormal images c_i = A u_i
+            std::deque<SmartPtr<vector_type>> m_spU;
+            std::deque<SmartPtr<vector_type>> m_spC;
+        };
+
+    } // namespace RegressionTest
+} // namespace ug
+
+#endif /* UG4TESTS_REGRESSION_TESTS_RECYCLING_SOLVER_H */
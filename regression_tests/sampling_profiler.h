@@ -0,0 +1,487 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef UG4TESTS_REGRESSION_TESTS_SAMPLING_PROFILER_H
+#define UG4TESTS_REGRESSION_TESTS_SAMPLING_PROFILER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#ifdef __linux__
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <linux/perf_event.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef UG_PARALLEL
+#include "pcl/pcl.h"
+#endif
+
+#include "phase_observer.h"
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Statistical profiler sampling the call stacks of the running tests
+         *
+         * Uses perf_event task clock sampling events on the process, one per CPU and
+         * inherited by the threads it starts, which are enabled only while a test runs.
+         * The kernel records the user space call stack of every sample into the ring
+         * buffer of the CPU, which a background thread drains. Samples are tagged with
+         * the test and the innermost testcase phase running at the time of the sample and
+         * written at the end of the test program as folded stacks,
+         * "test;phase;main;...;leaf count" per line, the input of flamegraph.pl and
+         * speedscope. The events are opened at the start of the test program.
+         *
+         * The kernel walks the user stack by frame pointers, so the stacks are complete
+         * only for code compiled with -fno-omit-frame-pointer. Functions are resolved
+         * with dladdr, which needs the executable linked with exported symbols. If
+         * perf_event_open is not available, e.g. on other platforms, in containers or
+         * with a restrictive kernel.perf_event_paranoid, a warning is printed and the
+         * tests run without profiling.
+         */
+        class SamplingProfiler : public ::testing::EmptyTestEventListener, public PhaseObserver
+        {
+        public:
+            /**
+             * \param[in] filename   output file of the folded stacks
+             * \param[in] frequency  samples per second and thread
+             */
+            SamplingProfiler(const std::string &filename, int frequency = 999)
+                : m_filename(filename), m_frequency(frequency), m_pageSize(0), m_bufferSize(0), m_stop(false),
+                  m_numSamples(0), m_numLost(0)
+            {
+            }
+
+            virtual ~SamplingProfiler()
+            {
+                close();
+            }
+
+            /**
+             * \return true if samples are taken
+             */
+            bool active() const
+            {
+                return !m_buffers.empty();
+            }
+
+            virtual void OnTestProgramStart(const ::testing::UnitTest & /*unitTest*/)
+            {
+                AddPhaseObserver(this);
+                open(m_frequency);
+            }
+
+            virtual void OnTestStart(const ::testing::TestInfo &testInfo)
+            {
+                m_test = std::string(testInfo.test_suite_name()) + "." + testInfo.name();
+                m_phases.clear();
+                retag();
+#ifdef __linux__
+                for (const RingBuffer &buffer : m_buffers)
+                    ioctl(buffer.fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+            }
+
+            virtual void OnTestEnd(const ::testing::TestInfo & /*testInfo*/)
+            {
+#ifdef __linux__
+                for (const RingBuffer &buffer : m_buffers)
+                    ioctl(buffer.fd, PERF_EVENT_IOC_DISABLE, 0);
+#endif
+                drain();
+                m_test.clear();
+                m_phases.clear();
+                retag();
+            }
+
+            virtual void OnTestProgramEnd(const ::testing::UnitTest & /*unitTest*/)
+            {
+                RemovePhaseObserver(this);
+                close();
+                write();
+            }
+
+            virtual void phase_started(const std::string &phase)
+            {
+                m_phases.push_back(phase);
+                retag();
+            }
+
+            virtual void phase_stopped(const std::string &phase, double /*seconds*/)
+            {
+                std::vector<std::string>::reverse_iterator it = std::find(m_phases.rbegin(), m_phases.rend(), phase);
+                if (it != m_phases.rend())
+                    m_phases.erase(std::next(it).base());
+                retag();
+            }
+
+        protected:
+            /// sampling event of one CPU and its mapped ring buffer
+            struct RingBuffer
+            {
+                int fd;
+                void *map;
+            };
+
+            /// \return CLOCK_MONOTONIC in nanoseconds, the clock of the samples
+            static uint64_t monotonic_ns()
+            {
+                timespec ts;
+                clock_gettime(CLOCK_MONOTONIC, &ts);
+                return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+            }
+
+            /// records the tag of the samples from now on
+            void retag()
+            {
+                std::string tag = m_test;
+                if (!m_phases.empty())
+                    tag += ";" + m_phases.back();
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_tags.push_back(std::make_pair(monotonic_ns(), tag));
+            }
+
+            /// \return tag at the given time, m_mutex has to be locked
+            const std::string &tag_at(uint64_t time) const
+            {
+                static const std::string none;
+                std::vector<std::pair<uint64_t, std::string>>::const_iterator it =
+                    std::upper_bound(m_tags.begin(), m_tags.end(), std::make_pair(time, std::string()),
+                                     [](const std::pair<uint64_t, std::string> &a, const std::pair<uint64_t, std::string> &b)
+                                     { return a.first < b.first; });
+                return it == m_tags.begin() ? none : std::prev(it)->second;
+            }
+
+            void open(int frequency)
+            {
+#ifdef __linux__
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = PERF_TYPE_SOFTWARE;
+                attr.config = PERF_COUNT_SW_TASK_CLOCK;
+                attr.freq = 1;
+                attr.sample_freq = frequency;
+                attr.sample_type = PERF_SAMPLE_TID | PERF_SAMPLE_TIME | PERF_SAMPLE_CALLCHAIN;
+                attr.disabled = 1;
+                attr.inherit = 1;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.exclude_callchain_kernel = 1;
+                attr.use_clockid = 1;
+                attr.clockid = CLOCK_MONOTONIC;
+
+                // 1 metadata page and 2^8 data pages per CPU, the reader is woken up at half
+                m_pageSize = sysconf(_SC_PAGESIZE);
+                m_bufferSize = 256 * m_pageSize;
+                attr.watermark = 1;
+                attr.wakeup_watermark = m_bufferSize / 2;
+
+                // the kernel maps inherited events only per CPU
+                const long numCPUs = sysconf(_SC_NPROCESSORS_CONF);
+                for (long cpu = 0; cpu < numCPUs; cpu++)
+                {
+                    RingBuffer buffer;
+                    buffer.fd = syscall(__NR_perf_event_open, &attr, 0, cpu, -1, PERF_FLAG_FD_CLOEXEC);
+                    if (buffer.fd < 0)
+                    {
+                        // offline CPU
+                        if (errno == ENODEV)
+                            continue;
+                        std::cerr << "SamplingProfiler: perf_event_open failed (" << std::strerror(errno)
+                                  << "), running without profiling. Check /proc/sys/kernel/perf_event_paranoid." << std::endl;
+                        close();
+                        return;
+                    }
+
+                    buffer.map = mmap(nullptr, m_pageSize + m_bufferSize, PROT_READ | PROT_WRITE, MAP_SHARED, buffer.fd, 0);
+                    if (buffer.map == MAP_FAILED)
+                    {
+                        std::cerr << "SamplingProfiler: mapping the sample buffer failed (" << std::strerror(errno)
+                                  << "), running without profiling." << std::endl;
+                        ::close(buffer.fd);
+                        close();
+                        return;
+                    }
+                    m_buffers.push_back(buffer);
+                }
+                if (active())
+                    m_reader = std::thread(&SamplingProfiler::read_loop, this);
+#else
+                std::cerr << "SamplingProfiler: perf_event is not available on this platform, running without profiling." << std::endl;
+#endif
+            }
+
+            void close()
+            {
+#ifdef __linux__
+                if (m_reader.joinable())
+                {
+                    m_stop = true;
+                    m_reader.join();
+                }
+                drain();
+                for (const RingBuffer &buffer : m_buffers)
+                {
+                    munmap(buffer.map, m_pageSize + m_bufferSize);
+                    ::close(buffer.fd);
+                }
+                m_buffers.clear();
+#endif
+            }
+
+#ifdef __linux__
+            void read_loop()
+            {
+                std::vector<pollfd> fds(m_buffers.size());
+                for (size_t i = 0; i < fds.size(); i++)
+                {
+                    fds[i].fd = m_buffers[i].fd;
+                    fds[i].events = POLLIN;
+                }
+                while (!m_stop)
+                {
+                    poll(fds.data(), fds.size(), 100);
+                    drain();
+                }
+            }
+#endif
+
+            /// moves all samples from the ring buffers into the stacks
+            void drain()
+            {
+#ifdef __linux__
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (const RingBuffer &buffer : m_buffers)
+                {
+                    perf_event_mmap_page *meta = (perf_event_mmap_page *)buffer.map;
+                    const char *data = (const char *)buffer.map + m_pageSize;
+                    const uint64_t head = __atomic_load_n(&meta->data_head, __ATOMIC_ACQUIRE);
+                    const uint64_t tail = read_records(data, meta->data_tail, head);
+                    __atomic_store_n(&meta->data_tail, tail, __ATOMIC_RELEASE);
+                }
+#endif
+            }
+
+#ifdef __linux__
+            /**
+             * parses the records between the positions tail and head of a ring buffer of
+             * m_bufferSize bytes, m_mutex has to be locked
+             *
+             * \return position behind the last complete record
+             */
+            uint64_t read_records(const char *data, uint64_t tail, uint64_t head)
+            {
+                std::vector<char> record;
+                while (tail < head)
+                {
+                    perf_event_header header;
+                    copy(data, tail, sizeof(header), (char *)&header);
+                    if (header.size < sizeof(header) || tail + header.size > head)
+                        break;
+                    record.resize(header.size);
+                    copy(data, tail, header.size, record.data());
+                    tail += header.size;
+
+                    if (header.type == PERF_RECORD_SAMPLE)
+                        add_sample(record.data() + sizeof(header), record.data() + record.size());
+                    else if (header.type == PERF_RECORD_LOST && header.size >= sizeof(header) + 2 * sizeof(uint64_t))
+                        m_numLost += *(const uint64_t *)(record.data() + sizeof(header) + sizeof(uint64_t));
+                }
+                return tail;
+            }
+#endif
+
+            /// copies size bytes at offset pos of the ring buffer, which may wrap around
+            void copy(const char *data, uint64_t pos, size_t size, char *out) const
+            {
+                for (size_t i = 0; i < size; i++)
+                    out[i] = data[(pos + i) % m_bufferSize];
+            }
+
+            /// adds a sample record: pid, tid, time, number of frames, frames (leaf first)
+            void add_sample(const char *begin, const char *end)
+            {
+#ifdef __linux__
+                const uint64_t *p = (const uint64_t *)begin;
+                if ((const char *)(p + 3) > end)
+                    return;
+                const uint64_t time = p[1];
+                const uint64_t nr = p[2];
+                const uint64_t *ips = p + 3;
+                if ((const char *)(ips + nr) > end)
+                    return;
+
+                const std::string &tag = tag_at(time);
+                if (tag.empty())
+                    return;
+
+                std::vector<uint64_t> stack;
+                for (uint64_t i = 0; i < nr; i++)
+                    if (ips[i] < (uint64_t)PERF_CONTEXT_MAX)
+                        stack.push_back(ips[i]);
+                m_stacks[std::make_pair(tag, stack)]++;
+                m_numSamples++;
+#endif
+            }
+
+            /// \return function name of a code address, module+offset if it has no symbol
+            std::string symbol(uint64_t address, bool leaf)
+            {
+                std::map<uint64_t, std::string>::const_iterator cached = m_symbols.find(address);
+                if (cached != m_symbols.end())
+                    return cached->second;
+
+                std::string name;
+#ifdef __linux__
+                // return addresses point behind the call, which may be the next function
+                const void *pc = (const void *)(leaf ? address : address - 1);
+                Dl_info info;
+                if (dladdr(pc, &info) != 0)
+                {
+                    if (info.dli_sname != nullptr)
+                    {
+                        int status;
+                        char *demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+                        name = status == 0 ? demangled : info.dli_sname;
+                        std::free(demangled);
+                    }
+                    else if (info.dli_fname != nullptr)
+                    {
+                        std::string module = info.dli_fname;
+                        module = module.substr(module.find_last_of('/') + 1);
+                        char offset[32];
+                        std::snprintf(offset, sizeof(offset), "+0x%llx", (unsigned long long)((const char *)pc - (const char *)info.dli_fbase));
+                        name = module + offset;
+                    }
+                }
+#endif
+                if (name.empty())
+                {
+                    char buffer[32];
+                    std::snprintf(buffer, sizeof(buffer), "0x%llx", (unsigned long long)address);
+                    name = buffer;
+                }
+                std::replace(name.begin(), name.end(), ';', ',');
+                m_symbols[address] = name;
+                return name;
+            }
+
+            void write()
+            {
+                if (m_stacks.empty())
+                    return;
+
+                std::string filename = m_filename;
+#ifdef UG_PARALLEL
+                if (pcl::NumProcs() > 1)
+                    filename += "." + std::to_string(pcl::ProcRank());
+#endif
+                // stacks with the same function names are merged
+                std::map<std::string, size_t> folded;
+                for (std::map<std::pair<std::string, std::vector<uint64_t>>, size_t>::const_iterator it = m_stacks.begin();
+                     it != m_stacks.end(); ++it)
+                {
+                    std::string line = it->first.first;
+                    const std::vector<uint64_t> &stack = it->first.second;
+                    for (size_t i = stack.size(); i > 0; i--)
+                        line += ";" + symbol(stack[i - 1], i == 1);
+                    folded[line] += it->second;
+                }
+
+                std::ofstream out(filename);
+                for (std::map<std::string, size_t>::const_iterator it = folded.begin(); it != folded.end(); ++it)
+                    out << it->first << " " << it->second << "\n";
+                if (!out)
+                {
+                    std::cerr << "SamplingProfiler: could not write '" << filename << "'" << std::endl;
+                    return;
+                }
+                std::cout << "SamplingProfiler: " << m_numSamples << " samples written to '" << filename << "'";
+                if (m_numLost > 0)
+                    std::cout << ", " << m_numLost << " samples lost";
+                std::cout << std::endl;
+            }
+
+            std::string m_filename;
+            int m_frequency;
+            std::vector<RingBuffer> m_buffers;
+            size_t m_pageSize;
+            /// size of the data part of each ring buffer, a power of two pages
+            size_t m_bufferSize;
+            std::thread m_reader;
+            std::atomic<bool> m_stop;
+
+            /// test and phase stack of the main thread
+            std::string m_test;
+            std::vector<std::string> m_phases;
+
+            /// guards the tags, the stacks and the ring buffers
+            std::mutex m_mutex;
+            /// time in ns and tag of the samples from then on, ascending
+            std::vector<std::pair<uint64_t, std::string>> m_tags;
+            std::map<std::pair<std::string, std::vector<uint64_t>>, size_t> m_stacks;
+            std::map<uint64_t, std::string> m_symbols;
+            size_t m_numSamples;
+            size_t m_numLost;
+        };
+
+    } // namespace RegressionTest
+} // namespace ug
+
+#endif /* UG4TESTS_REGRESSION_TESTS_SAMPLING_PROFILER_H */
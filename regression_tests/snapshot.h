@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef UG4TESTS_REGRESSION_TESTS_SNAPSHOT_H
+#define UG4TESTS_REGRESSION_TESTS_SNAPSHOT_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ug.h"
+#include "ugbase.h"
+#include "lib_algebra/operator/interface/matrix_operator.h"
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Assembled linear system together with its multigrid hierarchy
+         *
+         * Contains everything a solver benchmark needs, without grid, approximation
+         * space or discretization: the level matrices from the base level up to the top
+         * level, right-hand side and start vector on the top level, the Dirichlet rows of
+         * the top level and the transfer matrices between neighbouring levels.
+         * prolongations[l] and restrictions[l] connect the levels l and l+1.
+         */
+        struct Snapshot
+        {
+            typedef CPUAlgebra::matrix_type matrix_type;
+            typedef CPUAlgebra::vector_type vector_type;
+            typedef MatrixOperator<matrix_type, vector_type> TOperator;
+
+            std::vector<SmartPtr<TOperator>> levelMatrices;
+            std::vector<SmartPtr<matrix_type>> prolongations;
+            std::vector<SmartPtr<matrix_type>> restrictions;
+            SmartPtr<vector_type> spB;
+            SmartPtr<vector_type> spU;
+            std::vector<size_t> dirichletRows;
+        };
+
+        namespace snapshot
+        {
+            static const char magic[8] = {'U', 'G', '4', 'S', 'N', 'A', 'P', '1'};
+
+            inline void write_size(std::ostream &os, uint64_t size)
+            {
+                os.write(reinterpret_cast<const char *>(&size), sizeof(size));
+            }
+
+            inline uint64_t read_size(std::istream &is)
+            {
+                uint64_t size = 0;
+                is.read(reinterpret_cast<char *>(&size), sizeof(size));
+                return size;
+            }
+
+            /// writes a matrix in CSR format: rows, columns, non-zeros, row pointers, column indices, values
+            inline void write_matrix(std::ostream &os, const Snapshot::matrix_type &A)
+            {
+                std::vector<uint64_t> rowStart(1, 0);
+                std::vector<uint64_t> cols;
+                std::vector<double> values;
+                for (size_t i = 0; i < A.num_rows(); i++)
+                {
+                    for (Snapshot::matrix_type::const_row_iterator it = A.begin_row(i); it != A.end_row(i); ++it)
+                    {
+                        cols.push_back(it.index());
+                        values.push_back(it.value());
+                    }
+                    rowStart.push_back(cols.size());
+                }
+
+                write_size(os, A.num_rows());
+                write_size(os, A.num_cols());
+                write_size(os, cols.size());
+                os.write(reinterpret_cast<const char *>(rowStart.data()), rowStart.size() * sizeof(uint64_t));
+                os.write(reinterpret_cast<const char *>(cols.data()), cols.size() * sizeof(uint64_t));
+                os.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(double));
+            }
+
+            inline void read_matrix(std::istream &is, Snapshot::matrix_type &A)
+            {
+                const uint64_t numRows = read_size(is);
+                const uint64_t numCols = read_size(is);
+                const uint64_t nnz = read_size(is);
+
+                std::vector<uint64_t> rowStart(numRows + 1);
+                std::vector<uint64_t> cols(nnz);
+                std::vector<double> values(nnz);
+                is.read(reinterpret_cast<char *>(rowStart.data()), rowStart.size() * sizeof(uint64_t));
+                is.read(reinterpret_cast<char *>(cols.data()), cols.size() * sizeof(uint64_t));
+                is.read(reinterpret_cast<char *>(values.data()), values.size() * sizeof(double));
+                if (!is)
+                    UG_THROW("ReadSnapshot: unexpected end of file.");
+
+                A.resize_and_clear(numRows, numCols);
+                for (uint64_t i = 0; i < numRows; i++)
+                    for (uint64_t k = rowStart[i]; k < rowStart[i + 1]; k++)
+                        A(i, cols[k]) = values[k];
+                A.defragment();
+            }
+
+            inline void write_vector(std::ostream &os, const Snapshot::vector_type &v)
+            {
+                write_size(os, v.size());
+                for (size_t i = 0; i < v.size(); i++)
+                    os.write(reinterpret_cast<const char *>(&v[i]), sizeof(double));
+            }
+
+            inline void read_vector(std::istream &is, Snapshot::vector_type &v)
+            {
+                std::vector<double> values(read_size(is));
+                is.read(reinterpret_cast<char *>(values.data()), values.size() * sizeof(double));
+                if (!is)
+                    UG_THROW("ReadSnapshot: unexpected end of file.");
+
+                v.resize(values.size());
+                for (size_t i = 0; i < values.size(); i++)
+                    v[i] = values[i];
+            }
+        } // namespace snapshot
+
+        /**
+         * \brief Collects the Dirichlet rows of a matrix
+         *
+         * Rows assembled by the DirichletBoundary consist of the unit diagonal only.
+         *
+         * \param[in]    A       matrix
+         * \param[out]   rows    indices of the Dirichlet rows
+         */
+        inline void FindDirichletRows(const Snapshot::matrix_type &A, std::vector<size_t> &rows)
+        {
+            rows.clear();
+            for (size_t i = 0; i < A.num_rows(); i++)
+            {
+                bool dirichlet = false;
+                size_t numNonZero = 0;
+                for (Snapshot::matrix_type::const_row_iterator it = A.begin_row(i); it != A.end_row(i); ++it)
+                {
+                    if (it.value() == 0.0)
+                        continue;
+                    numNonZero++;
+                    dirichlet = (it.index() == i && it.value() == 1.0);
+                }
+                if (numNonZero == 1 && dirichlet)
+                    rows.push_back(i);
+            }
+        }
+
+        /**
+         * \brief Writes a snapshot to a binary file
+         *
+         * \param[in]    filename    name of the file
+         * \param[in]    snap        snapshot
+         */
+        inline void WriteSnapshot(const std::string &filename, const Snapshot &snap)
+        {
+            std::ofstream os(filename, std::ios::binary);
+            if (!os)
+                UG_THROW("WriteSnapshot: cannot open '" << filename << "'.");
+
+            os.write(snapshot::magic, sizeof(snapshot::magic));
+            snapshot::write_size(os, snap.levelMatrices.size());
+            for (size_t l = 0; l < snap.levelMatrices.size(); l++)
+                snapshot::write_matrix(os, *snap.levelMatrices[l]);
+            for (size_t l = 0; l + 1 < snap.levelMatrices.size(); l++)
+            {
+                snapshot::write_matrix(os, *snap.prolongations[l]);
+                snapshot::write_matrix(os, *snap.restrictions[l]);
+            }
+            snapshot::write_vector(os, *snap.spB);
+            snapshot::write_vector(os, *snap.spU);
+
+            std::vector<uint64_t> rows(snap.dirichletRows.begin(), snap.dirichletRows.end());
+            snapshot::write_size(os, rows.size());
+            os.write(reinterpret_cast<const char *>(rows.data()), rows.size() * sizeof(uint64_t));
+        }
+
+        /**
+         * \brief Reads a snapshot from a binary file
+         *
+         * \param[in]    filename    name of the file
+         * \param[out]   snap        snapshot
+         */
+        inline void ReadSnapshot(const std::string &filename, Snapshot &snap)
+        {
+            std::ifstream is(filename, std::ios::binary);
+            char magic[sizeof(snapshot::magic)];
+            is.read(magic, sizeof(magic));
+            if (!is || std::memcmp(magic, snapshot::magic, sizeof(magic)) != 0)
+                UG_THROW("ReadSnapshot: '" << filename << "' is not a snapshot file.");
+
+            const uint64_t numLevels = snapshot::read_size(is);
+            snap.levelMatrices.resize(numLevels);
+            for (uint64_t l = 0; l < numLevels; l++)
+            {
+                snap.levelMatrices[l] = make_sp(new Snapshot::TOperator());
+                snapshot::read_matrix(is, *snap.levelMatrices[l]);
+            }
+
+            snap.prolongations.resize(numLevels > 0 ? numLevels - 1 : 0);
+            snap.restrictions.resize(snap.prolongations.size());
+            for (size_t l = 0; l < snap.prolongations.size(); l++)
+            {
+                snap.prolongations[l] = make_sp(new Snapshot::matrix_type());
+                snap.restrictions[l] = make_sp(new Snapshot::matrix_type());
+                snapshot::read_matrix(is, *snap.prolongations[l]);
+                snapshot::read_matrix(is, *snap.restrictions[l]);
+            }
+
+            snap.spB = make_sp(new Snapshot::vector_type());
+            snap.spU = make_sp(new Snapshot::vector_type());
+            snapshot::read_vector(is, *snap.spB);
+            snapshot::read_vector(is, *snap.spU);
+
+            std::vector<uint64_t> rows(snapshot::read_size(is));
+            is.read(reinterpret_cast<char *>(rows.data()), rows.size() * sizeof(uint64_t));
+            if (!is)
+                UG_THROW("ReadSnapshot: unexpected end of file.");
+            snap.dirichletRows.assign(rows.begin(), rows.end());
+        }
+
+    } // namespace RegressionTest
+} // namespace ug
+
+#endif /* UG4TESTS_REGRESSION_TESTS_SNAPSHOT_H */
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef UG4TESTS_REGRESSION_TESTS_SNAPSHOT_MULTIGRID_H
+#define UG4TESTS_REGRESSION_TESTS_SNAPSHOT_MULTIGRID_H
+
+#include <vector>
+
+#include "ug.h"
+#include "ugbase.h"
+#include "lib_algebra/operator/interface/linear_iterator.h"
+#include "lib_algebra/operator/preconditioner/jacobi.h"
+#include "lib_algebra/operator/linear_solver/lu.h"
+
+#include "snapshot.h"
+#include "galerkin_product.h"
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Multigrid V-cycle on the hierarchy stored in a snapshot
+         *
+         * Purely algebraic counterpart of AssembledMultiGridCycle for snapshots: damped
+         * Jacobi smoothing on the stored level matrices, the stored transfer matrices
+         * and an LU base solver on the coarsest stored level. Allows benchmarking the
+         * solver without loading, refining and assembling. Serial only.
+         *
+         * With set_galerkin(true) the coarse level matrices are not taken from the
+         * snapshot but computed as Galerkin products R A P by GalerkinProduct, starting
+         * from the top level matrix; the sparsity patterns are kept, so a repeated init()
+         * after new matrix values only repeats the numeric phase.
+         */
+        class SnapshotMultigrid : public ILinearIterator<Snapshot::vector_type>
+        {
+            typedef Snapshot::vector_type vector_type;
+            typedef Snapshot::matrix_type matrix_type;
+            typedef ILinearIterator<vector_type> base_type;
+
+        public:
+            /**
+             * Constructor
+             *
+             * \param[in]    snap            snapshot holding the hierarchy
+             * \param[in]    numPreSmooth    number of pre-smoothing steps
+             * \param[in]    numPostSmooth   number of post-smoothing steps
+             * \param[in]    damping         damping of the Jacobi smoother
+             */
+            SnapshotMultigrid(const Snapshot &snap, int numPreSmooth = 3, int numPostSmooth = 3, number damping = 0.66)
+                : m_snap(snap), m_numPreSmooth(numPreSmooth), m_numPostSmooth(numPostSmooth), m_damping(damping),
+                  m_bGalerkin(false)
+            {
+            }
+
+            /**
+             * \param[in]    galerkin    if true, the coarse level matrices are computed as
+             *                           Galerkin products instead of taken from the snapshot
+             */
+            void set_galerkin(bool galerkin)
+            {
+                m_bGalerkin = galerkin;
+            }
+
+            /**
+             * \return matrix of level l used by the last init()
+             */
+            const matrix_type &level_matrix(size_t l) const
+            {
+                return *m_vA[l];
+            }
+
+            virtual const char *name() const { return "SnapshotMultigrid"; }
+
+            virtual bool supports_parallel() const { return false; }
+
+            virtual bool init(SmartPtr<ILinearOperator<vector_type>> J, const vector_type &u)
+            {
+                return init(J);
+            }
+
+            virtual bool init(SmartPtr<ILinearOperator<vector_type>> L)
+            {
+                const size_t numLevels = m_snap.levelMatrices.size();
+                if (numLevels == 0)
+                    UG_THROW("SnapshotMultigrid: snapshot contains no levels.");
+
+                m_vSmoother.resize(numLevels);
+                m_vC.resize(numLevels);
+                m_vD.resize(numLevels);
+                m_vT.resize(numLevels);
+
+                // level matrices, the coarse ones rediscretized or as Galerkin products
+                m_vA.resize(numLevels);
+                m_vA[numLevels - 1] = m_snap.levelMatrices[numLevels - 1];
+                if (m_bGalerkin)
+                    m_vProduct.resize(numLevels - 1);
+                for (size_t l = numLevels - 1; l > 0; l--)
+                {
+                    if (!m_bGalerkin)
+                    {
+                        m_vA[l - 1] = m_snap.levelMatrices[l - 1];
+                        continue;
+                    }
+                    if (!m_vA[l - 1].valid() || m_vA[l - 1].get() == m_snap.levelMatrices[l - 1].get())
+                        m_vA[l - 1] = make_sp(new Snapshot::TOperator());
+                    m_vProduct[l - 1].multiply(*m_vA[l - 1], *m_snap.restrictions[l - 1], *m_vA[l], *m_snap.prolongations[l - 1]);
+                }
+
+                for (size_t l = 0; l < numLevels; l++)
+                {
+                    const size_t n = m_vA[l]->num_rows();
+                    m_vC[l] = make_sp(new vector_type(n));
+                    m_vD[l] = make_sp(new vector_type(n));
+                    m_vT[l] = make_sp(new vector_type(n));
+
+                    if (l == 0)
+                        continue;
+
+                    m_vSmoother[l] = make_sp(new Jacobi<CPUAlgebra>(m_damping));
+                    if (!m_vSmoother[l]->init(m_vA[l]))
+                        return false;
+                }
+
+                m_spBaseSolver = make_sp(new LU<CPUAlgebra>());
+                return m_spBaseSolver->init(m_vA[0]);
+            }
+
+            virtual bool apply(vector_type &c, const vector_type &d)
+            {
+                const size_t top = m_snap.levelMatrices.size() - 1;
+                VecScaleAssign(*m_vD[top], 1.0, d);
+                c.set(0.0);
+                return cycle(top, c, *m_vD[top]);
+            }
+
+            virtual bool apply_update_defect(vector_type &c, vector_type &d)
+            {
+                c.set(0.0);
+                return cycle(m_snap.levelMatrices.size() - 1, c, d);
+            }
+
+            virtual SmartPtr<base_type> clone()
+            {
+                SmartPtr<SnapshotMultigrid> clone = make_sp(new SnapshotMultigrid(m_snap, m_numPreSmooth, m_numPostSmooth, m_damping));
+                clone->set_galerkin(m_bGalerkin);
+                return clone;
+            }
+
+        protected:
+            /**
+             * performs a V-cycle on level l
+             *
+             * \param[in]        l   level
+             * \param[in,out]    x   correction, has to be zero on entry
+             * \param[in,out]    d   defect, updated by the correction
+             */
+            bool cycle(size_t l, vector_type &x, vector_type &d)
+            {
+                if (l == 0)
+                    return m_spBaseSolver->apply(x, d);
+
+                const matrix_type &A = *m_vA[l];
+                vector_type &t = *m_vT[l];
+                vector_type &cCoarse = *m_vC[l - 1];
+                vector_type &dCoarse = *m_vD[l - 1];
+
+                for (int i = 0; i < m_numPreSmooth; i++)
+                {
+                    if (!m_vSmoother[l]->apply_update_defect(t, d))
+                        return false;
+                    x += t;
+                }
+
+                m_snap.restrictions[l - 1]->apply(dCoarse, d);
+                cCoarse.set(0.0);
+                if (!cycle(l - 1, cCoarse, dCoarse))
+                    return false;
+
+                m_snap.prolongations[l - 1]->apply(t, cCoarse);
+                x += t;
+                A.matmul_minus(d, t);
+
+                for (int i = 0; i < m_numPostSmooth; i++)
+                {
+                    if (!m_vSmoother[l]->apply_update_defect(t, d))
+                        return false;
+                    x += t;
+                }
+
+                return true;
+            }
+
+            const Snapshot &m_snap;
+            int m_numPreSmooth;
+            int m_numPostSmooth;
+            number m_damping;
+            bool m_bGalerkin;
+            std::vector<SmartPtr<Snapshot::TOperator>> m_vA;
+            std::vector<GalerkinProduct> m_vProduct;
+            std::vector<SmartPtr<Jacobi<CPUAlgebra>>> m_vSmoother;
+            SmartPtr<LU<CPUAlgebra>> m_spBaseSolver;
+            std::vector<SmartPtr<vector_type>> m_vC;
+            std::vector<SmartPtr<vector_type>> m_vD;
+            std::vector<SmartPtr<vector_type>> m_vT;
+        };
+
+    } // namespace RegressionTest
+} // namespace ug
+
+#endif /* UG4TESTS_REGRESSION_TESTS_SNAPSHOT_MULTIGRID_H */
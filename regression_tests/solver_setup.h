@@ -0,0 +1,344 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef UG4TESTS_REGRESSION_TESTS_SOLVER_SETUP_H
+#define UG4TESTS_REGRESSION_TESTS_SOLVER_SETUP_H
+
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "ug.h"
+#include "ugbase.h"
+#include "lib_algebra/operator/linear_solver/bicgstab.h"
+#include "lib_algebra/operator/linear_solver/cg.h"
+#include "lib_algebra/operator/linear_solver/lu.h"
+#include "lib_algebra/operator/preconditioner/preconditioners.h"
+#include "lib_algebra/operator/linear_solver/agglomerating_solver.h"
+#include "lib_disc/operator/linear_operator/multi_grid_solver/mg_solver.h"
+#include "lib_disc/operator/linear_operator/std_transfer.h"
+#include "../../SuperLU/super_lu.h"
+
+#include "pipelined_bicgstab.h"
+#include "fused_krylov.h"
+#include "fused_jacobi.h"
+#include "chebyshev_smoother.h"
+#include "traced_operators.h"
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Settings of the geometric multigrid preconditioner used by the testcases
+         *
+         * The defaults are the hand-picked values of the Laplace testcase.
+         */
+        struct GMGSettings
+        {
+            GMGSettings()
+                : smoother("jacobi"), baseLevel(0), cycleType("V"), numPreSmooth(3), numPostSmooth(3),
+                  damping(0.66), rap(false), p1LagrangeOptimization(true), surfaceLevel(-1),
+                  baseSolver("superlu"), numBaseSweeps(10), chebyshevDegree(3)
+            {
+            }
+
+            /// smoother: "jacobi" (damped), "fused-jacobi" (damped, FusedJacobi, scalar only), "chebyshev" (scalar only), "gs", "sgs" or "ilu"
+            std::string smoother;
+            int baseLevel;
+            std::string cycleType;
+            int numPreSmooth;
+            int numPostSmooth;
+            number damping;
+            bool rap;
+            bool p1LagrangeOptimization;
+            /// level the multigrid is applied on, -1 for the top level
+            int surfaceLevel;
+            /// base solver: "superlu", "lu" (dense LU, factorized once in init) or "cg"
+            std::string baseSolver;
+            /// number of Jacobi preconditioned CG iterations of the "cg" base solver
+            int numBaseSweeps;
+            /// if set, the base solver is wrapped in a TracedLinearOperatorInverse timing it here
+            SmartPtr<SolverTimings> baseSolverTimings;
+            /// matrix-vector products per application of the "chebyshev" smoother
+            int chebyshevDegree;
+        };
+
+        /**
+         * \brief Writes multigrid settings as "key = value" lines
+         *
+         * \param[in]    out         output stream
+         * \param[in]    settings    multigrid settings
+         */
+        inline void WriteGMGSettings(std::ostream &out, const GMGSettings &settings)
+        {
+            out << "smoother = " << settings.smoother << "\n"
+                << "damping = " << settings.damping << "\n"
+                << "baseLevel = " << settings.baseLevel << "\n"
+                << "baseSolver = " << settings.baseSolver << "\n"
+                << "cycleType = " << settings.cycleType << "\n"
+                << "numPreSmooth = " << settings.numPreSmooth << "\n"
+                << "numPostSmooth = " << settings.numPostSmooth << "\n"
+                << "chebyshevDegree = " << settings.chebyshevDegree << "\n"
+                << "rap = " << settings.rap << "\n"
+                << "p1LagrangeOptimization = " << settings.p1LagrangeOptimization << "\n";
+        }
+
+        /**
+         * \brief Reads multigrid settings written by WriteGMGSettings
+         *
+         * Keys missing in the file keep their default values.
+         *
+         * \param[in]    filename    name of the settings file
+         * \return the settings
+         */
+        inline GMGSettings ReadGMGSettings(const std::string &filename)
+        {
+            std::ifstream in(filename);
+            if (!in)
+                UG_THROW("ReadGMGSettings: could not open '" << filename << "'.");
+
+            GMGSettings settings;
+            std::string key, eq;
+            while (in >> key >> eq)
+            {
+                if (eq != "=")
+                    UG_THROW("ReadGMGSettings: expected '=' after '" << key << "' in '" << filename << "'.");
+
+                if (key == "smoother")
+                    in >> settings.smoother;
+                else if (key == "damping")
+                    in >> settings.damping;
+                else if (key == "baseLevel")
+                    in >> settings.baseLevel;
+                else if (key == "baseSolver")
+                    in >> settings.baseSolver;
+                else if (key == "cycleType")
+                    in >> settings.cycleType;
+                else if (key == "numPreSmooth")
+                    in >> settings.numPreSmooth;
+                else if (key == "numPostSmooth")
+                    in >> settings.numPostSmooth;
+                else if (key == "chebyshevDegree")
+                    in >> settings.chebyshevDegree;
+                else if (key == "rap")
+                    in >> settings.rap;
+                else if (key == "p1LagrangeOptimization")
+                    in >> settings.p1LagrangeOptimization;
+                else
+                    UG_THROW("ReadGMGSettings: unknown key '" << key << "' in '" << filename << "'.");
+            }
+            return settings;
+        }
+
+        /**
+         * \brief Outcome of a single linear solve
+         */
+        struct SolveStatistics
+        {
+            SolveStatistics() : converged(false), iterations(0), seconds(0.0), joules(-1.0), numDoFs(0) {}
+
+            bool converged;
+            int iterations;
+            double seconds;
+            /// energy of the machine during setup and solve, negative if not measured
+            double joules;
+            size_t numDoFs;
+            std::vector<number> history;
+        };
+
+        /**
+         * \brief Creates the smoothers that work on scalar matrix entries only
+         *
+         * \param[in]    settings        multigrid settings
+         * \return the smoother
+         */
+        template <typename TAlgebra>
+        SmartPtr<ILinearIterator<typename TAlgebra::vector_type>> CreateScalarSmoother(const GMGSettings &settings, std::true_type)
+        {
+            if (settings.smoother == "fused-jacobi")
+                return make_sp(new FusedJacobi<TAlgebra>(settings.damping));
+            if (settings.smoother == "chebyshev")
+                return make_sp(new ChebyshevSmoother<TAlgebra>(settings.chebyshevDegree));
+
+            UG_THROW("CreateSmoother: unknown smoother '" << settings.smoother << "'.");
+        }
+
+        /**
+         * \brief Block algebras, for which the scalar smoothers are not instantiated
+         */
+        template <typename TAlgebra>
+        SmartPtr<ILinearIterator<typename TAlgebra::vector_type>> CreateScalarSmoother(const GMGSettings &settings, std::false_type)
+        {
+            UG_THROW("CreateSmoother: smoother '" << settings.smoother << "' needs scalar matrix entries, the algebra has block size "
+                                                   << TAlgebra::blockSize << ".");
+        }
+
+        /**
+         * \brief Creates the smoother selected in the multigrid settings
+         *
+         * \param[in]    settings        multigrid settings
+         * \return the smoother
+         */
+        template <typename TAlgebra>
+        SmartPtr<ILinearIterator<typename TAlgebra::vector_type>> CreateSmoother(const GMGSettings &settings)
+        {
+            if (settings.smoother == "jacobi")
+                return make_sp(new Jacobi<TAlgebra>(settings.damping));
+            if (settings.smoother == "fused-jacobi" || settings.smoother == "chebyshev")
+                return CreateScalarSmoother<TAlgebra>(settings, std::integral_constant<bool, TAlgebra::blockSize == 1>());
+            if (settings.smoother == "gs")
+                return make_sp(new GaussSeidel<TAlgebra>());
+            if (settings.smoother == "sgs")
+                return make_sp(new SymmetricGaussSeidel<TAlgebra>());
+            if (settings.smoother == "ilu")
+                return make_sp(new ILU<TAlgebra>());
+
+            UG_THROW("CreateSmoother: unknown smoother '" << settings.smoother << "'.");
+        }
+
+        /**
+         * \brief Creates a preconditioned Krylov solver
+         *
+         * \param[in]    method  "bicgstab", "cg", "pipelined" (PipelinedBiCGStab),
+         *                       "fused-bicgstab" (FusedBiCGStab) or "fused-cg" (FusedCG)
+         * \return the solver, without preconditioner and convergence check
+         */
+        template <typename TVector>
+        SmartPtr<IPreconditionedLinearOperatorInverse<TVector>> CreateKrylovSolver(const std::string &method)
+        {
+            if (method == "bicgstab")
+                return make_sp(new BiCGStab<TVector>());
+            if (method == "cg")
+                return make_sp(new CG<TVector>());
+            if (method == "pipelined")
+                return make_sp(new PipelinedBiCGStab<TVector>());
+            if (method == "fused-bicgstab")
+                return make_sp(new FusedBiCGStab<TVector>());
+            if (method == "fused-cg")
+                return make_sp(new FusedCG<TVector>());
+
+            UG_THROW("CreateKrylovSolver: unknown Krylov method '" << method << "'.");
+        }
+
+        /**
+         * \brief Creates the base solver selected in the multigrid settings
+         *
+         * The direct solvers are wrapped in an AgglomeratingSolver, CG runs distributed.
+         *
+         * \param[in]    settings        multigrid settings
+         * \return the base solver
+         */
+        template <typename TAlgebra>
+        SmartPtr<ILinearOperatorInverse<typename TAlgebra::vector_type>> CreateBaseSolver(const GMGSettings &settings)
+        {
+            typedef typename TAlgebra::vector_type vector_type;
+
+            SmartPtr<ILinearOperatorInverse<vector_type>> baseSolver;
+            if (settings.baseSolver == "superlu")
+                baseSolver = make_sp(new AgglomeratingSolver<TAlgebra>(make_sp(new SuperLUSolver<TAlgebra>())));
+            else if (settings.baseSolver == "lu")
+                baseSolver = make_sp(new AgglomeratingSolver<TAlgebra>(make_sp(new LU<TAlgebra>())));
+            else if (settings.baseSolver == "cg")
+            {
+                SmartPtr<CG<vector_type>> cg = make_sp(new CG<vector_type>());
+                cg->set_preconditioner(make_sp(new Jacobi<TAlgebra>(settings.damping)));
+                // a fixed number of sweeps, reaching it is not a failure
+                SmartPtr<StdConvCheck<vector_type>> convCheck = make_sp(new StdConvCheck<vector_type>(settings.numBaseSweeps, 0.0, 0.0, false));
+                convCheck->set_supress_unsuccessful(true);
+                cg->set_convergence_check(convCheck);
+                baseSolver = cg;
+            }
+            else
+                UG_THROW("CreateBaseSolver: unknown base solver '" << settings.baseSolver << "'.");
+
+            return baseSolver;
+        }
+
+        /**
+         * \brief Creates the geometric multigrid preconditioner of the testcases
+         *
+         * Smoother and base solver as selected in the settings and the standard transfer operators.
+         *
+         * \param[in]    spApproxSpace   approximation space of the problem
+         * \param[in]    settings        multigrid settings
+         * \return the configured preconditioner
+         */
+        template <typename TDomain, typename TAlgebra>
+        SmartPtr<AssembledMultiGridCycle<TDomain, TAlgebra>>
+        CreateGMG(SmartPtr<ApproximationSpace<TDomain>> spApproxSpace, const GMGSettings &settings = GMGSettings())
+        {
+            typedef typename TAlgebra::vector_type vector_type;
+            typedef AssembledMultiGridCycle<TDomain, TAlgebra> GMG;
+
+            // Smoother
+            SmartPtr<ILinearIterator<vector_type>> smoother = CreateSmoother<TAlgebra>(settings);
+
+            // Base Solver, SuperLU by default
+            SmartPtr<ILinearOperatorInverse<vector_type>> baseSolver = CreateBaseSolver<TAlgebra>(settings);
+
+            // Spans for the smoother per level and the base solver, if traced, and the
+            // timings of the base solver, if requested
+            const std::string baseSpan = SolverSpansRequested() ? "base solver" : "";
+            if (!baseSpan.empty())
+                smoother = make_sp(new TracedLinearIterator<TAlgebra>(smoother));
+            if (!baseSpan.empty() || settings.baseSolverTimings.valid())
+                baseSolver = make_sp(new TracedLinearOperatorInverse<vector_type>(baseSolver, baseSpan, settings.baseSolverTimings));
+
+            // Transfer
+            SmartPtr<StdTransfer<TDomain, TAlgebra>> transfer = make_sp(new StdTransfer<TDomain, TAlgebra>());
+            transfer->enable_p1_lagrange_optimization(settings.p1LagrangeOptimization);
+
+            // Geometric Multigrid Preconditioner
+            SmartPtr<GMG> gmg = make_sp(new GMG(spApproxSpace));
+            gmg->set_base_solver(baseSolver);
+            gmg->set_smoother(smoother);
+            gmg->set_base_level(settings.baseLevel);
+            gmg->set_cycle_type(settings.cycleType);
+            gmg->set_num_presmooth(settings.numPreSmooth);
+            gmg->set_num_postsmooth(settings.numPostSmooth);
+            gmg->set_rap(settings.rap);
+            gmg->set_smooth_on_surface_rim(false);
+            gmg->set_emulate_full_refined_grid(false);
+            gmg->set_gathered_base_solver_if_ambiguous(false);
+            gmg->set_transfer(transfer);
+            if (settings.surfaceLevel >= 0)
+                gmg->set_surface_level(settings.surfaceLevel);
+
+            return gmg;
+        }
+
+    } // namespace RegressionTest
+} // namespace ug
+
+#endif /* UG4TESTS_REGRESSION_TESTS_SOLVER_SETUP_H */
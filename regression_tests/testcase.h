@@ -30,30 +30,55 @@
  * GNU Lesser General Public License for more details.
  */
 
+#ifndef UG4TESTS_REGRESSION_TESTS_TESTCASE_H
+#define UG4TESTS_REGRESSION_TESTS_TESTCASE_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <map>
 #include <string>
+#include <vector>
 
 #include "ug.h"
 #include "ugbase.h"
 #include "lib_disc/domain.h"
 #include "lib_grid/refinement/global_multi_grid_refiner.h"
 
+#include "phase_observer.h"
+
 namespace ug
 {
     namespace test
     {
+        /**
+         * \return true if compare() writes the current solution as new reference before
+         *         comparing, set by the --update-references option of ug4tests
+         */
+        inline bool &UpdateReferences()
+        {
+            static bool update = false;
+            return update;
+        }
+
         /**
          * \brief Base class for all testcases for regression testing
          * 
          * \tparam dim Dimension of the problem
+         * \tparam TAlgebraType Algebra used for the discretization and the solvers
          */
-        template <int dim>
+        template <int dim, typename TAlgebraType = ug::CPUAlgebra>
         class Testcase
         {
 
         protected:
-            typedef ug::CPUAlgebra TAlgebra;
-            typedef TAlgebra::vector_type vector_type;
-            typedef TAlgebra::matrix_type matrix_type;
+            typedef TAlgebraType TAlgebra;
+            typedef typename TAlgebra::vector_type vector_type;
+            typedef typename TAlgebra::matrix_type matrix_type;
             typedef Domain<dim> TDomain;
             typedef ApproximationSpace<TDomain> TApproxSpace;
             typedef DirichletBoundary<TDomain, TAlgebra> TDirichletBoundary;
@@ -74,6 +99,19 @@ namespace ug
             {
                 m_gridname = grid;
                 m_reference = reference;
+                m_numRefs = 4;
+                m_trueResidual = 0.0;
+                m_residualTolerance = -1.0;
+            }
+
+            /**
+             * sets the number of global refinements applied to the loaded grid
+             *
+             * \param[in]    numRefs     number of refinements
+             */
+            void set_num_refs(int numRefs)
+            {
+                m_numRefs = numRefs;
             }
 
             void run()
@@ -82,14 +120,33 @@ namespace ug
             }
 
             /**
-             * Compares the solution with the reference solution
+             * Compares the solution with the reference solution. With --update-references
+             * the solution is written as new reference first.
              * 
-             * \return true if the solution is equal to the reference solution
+             * \return true if the solution is equal to the reference solution, false if
+             *         the reference does not exist
              */
             bool compare()
             {
+                ScopedSpan span("compare");
+                if (UpdateReferences())
+                    save_reference();
+
+                if (!has_reference())
+                {
+                    std::cout << "Reference " << m_reference << " does not exist, generate it with"
+                              << " ug4tests --update-references" << std::endl;
+                    return false;
+                }
                 read_reference();
 
+                if (m_spReference->size() != m_spSolution->size())
+                {
+                    std::cout << "Size mismatch: solution has " << m_spSolution->size()
+                              << " entries, reference has " << m_spReference->size() << std::endl;
+                    return false;
+                }
+
                 for (size_t i = 0; i < m_spSolution->size(); i++)
                 {
                     if (!isEqual((*m_spSolution)[i], (*m_spReference)[i]))
@@ -102,6 +159,101 @@ namespace ug
                 return true;
             }
 
+            /**
+             * \brief Reference-free correctness check
+             *
+             * Compares the true residual ||b - A·u|| of the solution, computed independently
+             * of the solver, with the tolerance requested from the solver. This catches
+             * solvers that only reduce their preconditioned or recursively updated residual.
+             * The testcase has to record the residual with record_residual().
+             *
+             * \return true if the true residual satisfies the requested tolerance
+             */
+            bool check_residual() const
+            {
+                if (m_residualTolerance < 0.0)
+                    UG_THROW("check_residual(): the testcase does not record its residual.");
+
+                if (m_trueResidual > m_residualTolerance)
+                {
+                    std::cout << "True residual " << m_trueResidual << " exceeds the tolerance "
+                              << m_residualTolerance << std::endl;
+                    return false;
+                }
+
+                return true;
+            }
+
+            /**
+             * \return the true residual ||b - A·u|| recorded after the solve
+             */
+            number true_residual() const
+            {
+                return m_trueResidual;
+            }
+
+            /**
+             * \return true if the reference file exists
+             */
+            bool has_reference() const
+            {
+                std::ifstream is(m_reference);
+                return is.good();
+            }
+
+            /**
+             * writes the current solution as new reference solution
+             */
+            void save_reference()
+            {
+                write_reference(*m_spSolution);
+            }
+
+            /**
+             * \return the solution values to be compared with the reference
+             */
+            const std::vector<double> &solution() const
+            {
+                return *m_spSolution;
+            }
+
+            /**
+             * \return the approximation space of the problem, valid after run()
+             */
+            SmartPtr<TApproxSpace> approximation_space() const
+            {
+                return m_spApproxSpace;
+            }
+
+            /**
+             * \return accumulated wall clock time in seconds per phase
+             */
+            const std::map<string, double> &timings() const
+            {
+                return m_timings;
+            }
+
+            /**
+             * \return number of times each phase was executed
+             */
+            const std::map<string, size_t> &phase_calls() const
+            {
+                return m_phaseCalls;
+            }
+
+            /**
+             * prints the accumulated time and number of calls of all phases
+             */
+            void print_timings() const
+            {
+                for (std::map<string, double>::const_iterator it = m_timings.begin(); it != m_timings.end(); ++it)
+                {
+                    std::cout << std::setw(24) << std::left << it->first << std::right
+                              << std::setw(12) << std::fixed << std::setprecision(6) << it->second << " s"
+                              << std::setw(8) << m_phaseCalls.at(it->first) << " calls" << std::endl;
+                }
+            }
+
         protected:
             /**
              * \brief Refines the grid
@@ -113,7 +265,104 @@ namespace ug
                 GlobalMultiGridRefiner ref(*m_spDomain->grid(), m_spDomain->refinement_projector());
 
                 for (int i = 0; i < numRefs; i++)
+                {
+                    ScopedSpan span("refine level " + std::to_string(i + 1));
                     ref.refine();
+                }
+            }
+
+            /**
+             * stores the entries of a vector as solution to be compared with the reference,
+             * the components of block vectors one after another
+             *
+             * \param[in] u  solution vector
+             */
+            void store_solution(const vector_type &u)
+            {
+                SmartPtr<std::vector<double>> sol = make_sp(new std::vector<double>);
+                sol->reserve(u.size());
+                for (size_t i = 0; i < u.size(); i++)
+                    for (size_t j = 0; j < GetSize(u[i]); j++)
+                        sol->push_back(BlockRef(u[i], j));
+                m_spSolution = sol;
+                NotifyProblemSize(sol->size());
+            }
+
+            /**
+             * computes the residual norm ||b - A·u|| in a single pass over the matrix,
+             * fusing the matrix-vector product, the subtraction and the norm without a
+             * temporary vector
+             *
+             * \param[in] A  matrix
+             * \param[in] u  solution
+             * \param[in] b  right-hand side
+             * \return the residual norm
+             */
+            number residual_norm(const matrix_type &A, const vector_type &u, const vector_type &b) const
+            {
+                #ifdef UG_PARALLEL
+                if (pcl::NumProcs() > 1)
+                {
+                    // parallel vectors need the storage type handling of the algebra
+                    SmartPtr<vector_type> r = b.clone();
+                    A.matmul_minus(*r, u);
+                    return r->norm();
+                }
+                #endif
+
+                number sum = 0.0;
+                typename vector_type::value_type r;
+                for (size_t i = 0; i < A.num_rows(); i++)
+                {
+                    r = b[i];
+                    for (typename matrix_type::const_row_iterator it = A.begin_row(i); it != A.end_row(i); ++it)
+                        MatMultAdd(r, 1.0, r, -1.0, it.value(), u[it.index()]);
+                    sum += BlockNorm2(r);
+                }
+
+                return std::sqrt(sum);
+            }
+
+            /**
+             * records the true residual of the solution and the tolerance requested from
+             * the solver, max(minDefect, reduction * initialResidual), for check_residual()
+             *
+             * \param[in] A                  matrix
+             * \param[in] u                  solution
+             * \param[in] b                  right-hand side
+             * \param[in] initialResidual    residual norm of the start vector
+             * \param[in] minDefect          absolute tolerance of the solver
+             * \param[in] reduction          relative tolerance of the solver
+             */
+            void record_residual(const matrix_type &A, const vector_type &u, const vector_type &b,
+                                 number initialResidual, number minDefect, number reduction)
+            {
+                m_trueResidual = residual_norm(A, u, b);
+                m_residualTolerance = std::max(minDefect, reduction * initialResidual);
+            }
+
+            /**
+             * starts the wall clock timer of a phase
+             *
+             * \param[in] phase  name of the phase
+             */
+            void start_phase(const string &phase)
+            {
+                NotifyPhaseStarted(phase);
+                m_phaseStart[phase] = std::chrono::steady_clock::now();
+            }
+
+            /**
+             * stops the wall clock timer of a phase and accumulates the elapsed time
+             *
+             * \param[in] phase  name of the phase
+             */
+            void stop_phase(const string &phase)
+            {
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_phaseStart[phase];
+                m_timings[phase] += elapsed.count();
+                m_phaseCalls[phase]++;
+                NotifyPhaseStopped(phase, elapsed.count());
             }
 
             /**
@@ -123,10 +372,7 @@ namespace ug
              */
             void write_reference(std::vector<double> &vec)
             {
-                std::ofstream output_file(m_reference);
-
-                std::ostream_iterator<double> output_iterator(output_file, "\n");
-                std::copy(std::begin(vec), std::end(vec), output_iterator);
+                write_values(m_reference, vec);
             }
 
             /**
@@ -135,9 +381,73 @@ namespace ug
              */
             void read_reference()
             {
-                std::ifstream is(m_reference);
+                m_spReference = read_values(m_reference);
+            }
+
+            /**
+             * writes a vector of values to a file
+             * 
+             * \param[in] filename  name of the file
+             * \param[in] vec       vector to write
+             */
+            void write_values(const string &filename, const std::vector<double> &vec) const
+            {
+                if (binary_file(filename))
+                {
+                    std::ofstream output_file(filename, std::ios::binary);
+                    if (!output_file)
+                        UG_THROW("Testcase: could not write '" << filename << "'.");
+                    uint64_t size = vec.size();
+                    output_file.write(reinterpret_cast<const char *>(&size), sizeof(size));
+                    output_file.write(reinterpret_cast<const char *>(vec.data()), size * sizeof(double));
+                    return;
+                }
+
+                std::ofstream output_file(filename);
+                if (!output_file)
+                    UG_THROW("Testcase: could not write '" << filename << "'.");
+
+                std::ostream_iterator<double> output_iterator(output_file, "\n");
+                std::copy(std::begin(vec), std::end(vec), output_iterator);
+            }
+
+            /**
+             * reads a vector of values from a file
+             * 
+             * \param[in] filename  name of the file
+             * \return the values, empty if the file could not be read
+             */
+            SmartPtr<std::vector<double>> read_values(const string &filename) const
+            {
+                if (binary_file(filename))
+                {
+                    std::ifstream is(filename, std::ios::binary);
+                    uint64_t size = 0;
+                    is.read(reinterpret_cast<char *>(&size), sizeof(size));
+                    SmartPtr<std::vector<double>> values = make_sp(new std::vector<double>(size));
+                    is.read(reinterpret_cast<char *>(values->data()), size * sizeof(double));
+                    if (!is)
+                        values->clear();
+                    return values;
+                }
+
+                std::ifstream is(filename);
                 std::istream_iterator<double> start(is), end;
-                m_spReference = make_sp(new std::vector<double>(start, end));
+                return make_sp(new std::vector<double>(start, end));
+            }
+
+            /**
+             * files with the extension ".bin" are stored as a 64 bit entry count
+             * followed by the raw doubles, all others as text with one value per line
+             *
+             * \param[in] filename  name of the file
+             * \return true if the file is stored in binary format
+             */
+            bool binary_file(const string &filename) const
+            {
+                const string ext = ".bin";
+                return filename.size() >= ext.size() &&
+                       filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
             }
 
             /**
@@ -160,7 +470,15 @@ namespace ug
             SmartPtr<std::vector<double>> m_spSolution;
             string m_gridname;
             string m_reference;
+            int m_numRefs;
+            number m_trueResidual;
+            number m_residualTolerance;
+            std::map<string, double> m_timings;
+            std::map<string, size_t> m_phaseCalls;
+            std::map<string, std::chrono::steady_clock::time_point> m_phaseStart;
         };
 
     } // namespace RegressionTest
 } // namespace ug
+
+#endif /* UG4TESTS_REGRESSION_TESTS_TESTCASE_H */
@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef UG4TESTS_REGRESSION_TESTS_TRACE_RECORDER_H
+#define UG4TESTS_REGRESSION_TESTS_TRACE_RECORDER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#ifdef UG_PARALLEL
+#include "pcl/pcl.h"
+#endif
+
+#include "phase_observer.h"
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \return the string escaped for a JSON string literal
+         */
+        inline std::string JsonEscape(const std::string &s)
+        {
+            std::string escaped;
+            for (char c : s)
+            {
+                if (c == '"' || c == '\\')
+                    escaped += std::string("\\") + c;
+                else if ((unsigned char)c < 0x20)
+                {
+                    char buffer[8];
+                    std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                    escaped += buffer;
+                }
+                else
+                    escaped += c;
+            }
+            return escaped;
+        }
+
+        /**
+         * \brief Writes a timeline of the test run in the Chrome trace event format
+         *
+         * Every test, testcase phase and span becomes a duration event on the thread
+         * it ran on, so the nesting of test, phases (load domain, refine, assembly, ...)
+         * and spans (refinement levels, smoother setup per level, solver iterations,
+         * compare) is kept. The file is written at the end of the test program and can
+         * be opened in chrome://tracing or ui.perfetto.dev. In parallel runs every
+         * process writes its own file with the rank appended to the name and the rank
+         * as process id, so the files of all processes can be merged. The recorder
+         * observes the testcases from the start until the end of the test program and
+         * requests the spans of the smoother and base solver calls.
+         */
+        class TraceRecorder : public ::testing::EmptyTestEventListener, public PhaseObserver
+        {
+            typedef std::chrono::steady_clock clock;
+
+        public:
+            /**
+             * \param[in] filename   output file
+             */
+            explicit TraceRecorder(const std::string &filename) : m_filename(filename), m_start(clock::now())
+            {
+                thread_index();
+            }
+
+            virtual void OnTestProgramStart(const ::testing::UnitTest & /*unitTest*/)
+            {
+                AddPhaseObserver(this);
+            }
+
+            virtual void OnTestStart(const ::testing::TestInfo &testInfo)
+            {
+                begin(std::string(testInfo.test_suite_name()) + "." + testInfo.name(), "test");
+            }
+
+            virtual void OnTestEnd(const ::testing::TestInfo &testInfo)
+            {
+                end(std::string(testInfo.test_suite_name()) + "." + testInfo.name(), "test");
+            }
+
+            virtual void OnTestProgramEnd(const ::testing::UnitTest & /*unitTest*/)
+            {
+                RemovePhaseObserver(this);
+                write();
+            }
+
+            virtual void phase_started(const std::string &phase)
+            {
+                begin(phase, "phase");
+            }
+
+            virtual void phase_stopped(const std::string &phase, double /*seconds*/)
+            {
+                end(phase, "phase");
+            }
+
+            virtual void span_started(const std::string &name)
+            {
+                begin(name, "span");
+            }
+
+            virtual void span_stopped(const std::string &name)
+            {
+                end(name, "span");
+            }
+
+            virtual bool wants_solver_spans() const
+            {
+                return true;
+            }
+
+        protected:
+            struct Event
+            {
+                char type;
+                std::string name;
+                const char *category;
+                double timestamp;
+                int thread;
+            };
+
+            /// \return small index of the calling thread, 0 for the thread creating the recorder
+            int thread_index()
+            {
+                const std::thread::id id = std::this_thread::get_id();
+                std::map<std::thread::id, int>::iterator it = m_threads.find(id);
+                if (it != m_threads.end())
+                    return it->second;
+                const int index = (int)m_threads.size();
+                m_threads[id] = index;
+                m_open.push_back(std::vector<std::string>());
+                return index;
+            }
+
+            /// \return microseconds since the creation of the recorder
+            double now() const
+            {
+                return std::chrono::duration<double, std::micro>(clock::now() - m_start).count();
+            }
+
+            void begin(const std::string &name, const char *category)
+            {
+                const double timestamp = now();
+                std::lock_guard<std::mutex> lock(m_mutex);
+                const int thread = thread_index();
+                m_open[thread].push_back(name);
+                m_events.push_back(Event{'B', name, category, timestamp, thread});
+            }
+
+            void end(const std::string &name, const char *category)
+            {
+                const double timestamp = now();
+                std::lock_guard<std::mutex> lock(m_mutex);
+                const int thread = thread_index();
+
+                // ignore an end without begin, close inner events left open, e.g. by an exception
+                std::vector<std::string> &open = m_open[thread];
+                if (std::find(open.begin(), open.end(), name) == open.end())
+                    return;
+                while (open.back() != name)
+                {
+                    m_events.push_back(Event{'E', open.back(), category, timestamp, thread});
+                    open.pop_back();
+                }
+                open.pop_back();
+                m_events.push_back(Event{'E', name, category, timestamp, thread});
+            }
+
+            void write()
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                int rank = 0;
+                std::string filename = m_filename;
+#ifdef UG_PARALLEL
+                rank = pcl::ProcRank();
+                if (pcl::NumProcs() > 1)
+                    filename += "." + std::to_string(rank);
+#endif
+                std::ofstream out(filename);
+                if (!out)
+                {
+                    std::cerr << "TraceRecorder: could not write '" << filename << "'" << std::endl;
+                    return;
+                }
+
+                out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+                out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << rank << ",\"args\":{\"name\":\"ug4tests rank " << rank
+                    << "\"}}";
+                for (size_t t = 0; t < m_threads.size(); t++)
+                    out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << rank << ",\"tid\":" << t << ",\"args\":{\"name\":\""
+                        << (t == 0 ? std::string("main") : "worker " + std::to_string(t)) << "\"}}";
+
+                char timestamp[32];
+                for (const Event &event : m_events)
+                {
+                    std::snprintf(timestamp, sizeof(timestamp), "%.3f", event.timestamp);
+                    out << ",\n{\"name\":\"" << JsonEscape(event.name) << "\",\"cat\":\"" << event.category << "\",\"ph\":\""
+                        << event.type << "\",\"ts\":" << timestamp << ",\"pid\":" << rank << ",\"tid\":" << event.thread << "}";
+                }
+                out << "\n]}\n";
+            }
+
+            std::string m_filename;
+            clock::time_point m_start;
+            std::mutex m_mutex;
+            std::map<std::thread::id, int> m_threads;
+            /// names of the open events per thread, innermost last
+            std::vector<std::vector<std::string>> m_open;
+            std::vector<Event> m_events;
+        };
+
+    } // namespace RegressionTest
+} // namespace ug
+
+#endif /* UG4TESTS_REGRESSION_TESTS_TRACE_RECORDER_H */
@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef UG4TESTS_REGRESSION_TESTS_TRACED_OPERATORS_H
+#define UG4TESTS_REGRESSION_TESTS_TRACED_OPERATORS_H
+
+#include <chrono>
+#include <string>
+
+#include "ug.h"
+#include "ugbase.h"
+#include "lib_algebra/operator/interface/linear_iterator.h"
+#include "lib_algebra/operator/interface/linear_operator_inverse.h"
+#include "lib_algebra/operator/interface/matrix_operator.h"
+
+#include "phase_observer.h"
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Decorator reporting setup and application of a multigrid smoother as spans
+         *
+         * The multigrid clones the smoother for every level, so the spans are named after
+         * the number of rows of the level matrix, e.g. "smoother setup (4913 rows)".
+         *
+         * \tparam TAlgebra algebra type
+         */
+        template <typename TAlgebra>
+        class TracedLinearIterator : public ILinearIterator<typename TAlgebra::vector_type>
+        {
+        public:
+            typedef typename TAlgebra::vector_type vector_type;
+            typedef typename TAlgebra::matrix_type matrix_type;
+            typedef ILinearIterator<vector_type> base_type;
+
+            /**
+             * \param[in]    spIterator  smoother to trace
+             */
+            explicit TracedLinearIterator(SmartPtr<base_type> spIterator) : m_spIterator(spIterator) {}
+
+            virtual const char *name() const { return m_spIterator->name(); }
+
+            virtual bool supports_parallel() const { return m_spIterator->supports_parallel(); }
+
+            virtual std::string config_string() const { return m_spIterator->config_string(); }
+
+            virtual bool init(SmartPtr<ILinearOperator<vector_type>> J, const vector_type &u)
+            {
+                set_rows(u.size());
+                ScopedSpan span("smoother setup" + m_rows);
+                return m_spIterator->init(J, u);
+            }
+
+            virtual bool init(SmartPtr<ILinearOperator<vector_type>> L)
+            {
+                SmartPtr<MatrixOperator<matrix_type, vector_type>> op = L.template cast_dynamic<MatrixOperator<matrix_type, vector_type>>();
+                if (op.valid())
+                    set_rows(op->get_matrix().num_rows());
+                ScopedSpan span("smoother setup" + m_rows);
+                return m_spIterator->init(L);
+            }
+
+            virtual bool apply(vector_type &c, const vector_type &d)
+            {
+                ScopedSpan span("smooth" + m_rows);
+                return m_spIterator->apply(c, d);
+            }
+
+            virtual bool apply_update_defect(vector_type &c, vector_type &d)
+            {
+                ScopedSpan span("smooth" + m_rows);
+                return m_spIterator->apply_update_defect(c, d);
+            }
+
+            virtual SmartPtr<base_type> clone()
+            {
+                return make_sp(new TracedLinearIterator<TAlgebra>(m_spIterator->clone()));
+            }
+
+        protected:
+            void set_rows(size_t rows)
+            {
+                m_rows = " (" + std::to_string(rows) + " rows)";
+            }
+
+            SmartPtr<base_type> m_spIterator;
+            /// suffix of the span names
+            std::string m_rows;
+        };
+
+        /**
+         * \brief Accumulated timings of a solver wrapped in a TracedLinearOperatorInverse
+         */
+        struct SolverTimings
+        {
+            SolverTimings() : initSeconds(0.0), numInit(0), applySeconds(0.0), numApply(0) {}
+
+            /// time spent in init(), e.g. the factorization of a direct solver
+            double initSeconds;
+            size_t numInit;
+            /// time spent in apply() and apply_return_defect()
+            double applySeconds;
+            size_t numApply;
+
+            double seconds_per_apply() const
+            {
+                return numApply > 0 ? applySeconds / numApply : 0.0;
+            }
+        };
+
+        /**
+         * \brief Decorator reporting setup and application of a solver as spans and
+         * accumulating their time
+         *
+         * All calls are forwarded to the wrapped solver. Spans are only reported if a span
+         * name is given, timings only if a SolverTimings object is given; it can be shared
+         * with the caller.
+         *
+         * \tparam TVector vector type
+         */
+        template <typename TVector>
+        class TracedLinearOperatorInverse : public ILinearOperatorInverse<TVector>
+        {
+        public:
+            typedef TVector vector_type;
+            typedef ILinearOperatorInverse<TVector> base_type;
+            typedef std::chrono::steady_clock clock;
+
+            /**
+             * \param[in]    spSolver    solver to trace
+             * \param[in]    spanName    name of the spans, e.g. "base solver"; empty for no spans
+             * \param[in]    spTimings   receives the timings, if valid
+             */
+            TracedLinearOperatorInverse(SmartPtr<base_type> spSolver, const std::string &spanName,
+                                        SmartPtr<SolverTimings> spTimings = SmartPtr<SolverTimings>())
+                : m_spSolver(spSolver), m_spanName(spanName), m_spTimings(spTimings)
+            {
+            }
+
+            virtual const char *name() const { return m_spSolver->name(); }
+
+            virtual bool supports_parallel() const { return m_spSolver->supports_parallel(); }
+
+            virtual bool init(SmartPtr<ILinearOperator<vector_type>> L)
+            {
+                const clock::time_point start = start_init();
+                const bool result = base_type::init(L) && m_spSolver->init(L);
+                stop_init(start);
+                return result;
+            }
+
+            virtual bool init(SmartPtr<ILinearOperator<vector_type>> J, const vector_type &u)
+            {
+                const clock::time_point start = start_init();
+                const bool result = base_type::init(J, u) && m_spSolver->init(J, u);
+                stop_init(start);
+                return result;
+            }
+
+            virtual bool apply(vector_type &u, const vector_type &f)
+            {
+                const clock::time_point start = start_apply();
+                const bool result = m_spSolver->apply(u, f);
+                stop_apply(start);
+                return result;
+            }
+
+            virtual bool apply_return_defect(vector_type &u, vector_type &f)
+            {
+                const clock::time_point start = start_apply();
+                const bool result = m_spSolver->apply_return_defect(u, f);
+                stop_apply(start);
+                return result;
+            }
+
+        protected:
+            clock::time_point start_init()
+            {
+                if (!m_spanName.empty())
+                    NotifySpanStarted(m_spanName + " setup");
+                return clock::now();
+            }
+
+            void stop_init(const clock::time_point &start)
+            {
+                if (m_spTimings.valid())
+                {
+                    m_spTimings->initSeconds += std::chrono::duration<double>(clock::now() - start).count();
+                    m_spTimings->numInit++;
+                }
+                if (!m_spanName.empty())
+                    NotifySpanStopped(m_spanName + " setup");
+            }
+
+            clock::time_point start_apply()
+            {
+                if (!m_spanName.empty())
+                    NotifySpanStarted(m_spanName);
+                return clock::now();
+            }
+
+            void stop_apply(const clock::time_point &start)
+            {
+                if (m_spTimings.valid())
+                {
+                    m_spTimings->applySeconds += std::chrono::duration<double>(clock::now() - start).count();
+                    m_spTimings->numApply++;
+                }
+                if (!m_spanName.empty())
+                    NotifySpanStopped(m_spanName);
+            }
+
+            SmartPtr<base_type> m_spSolver;
+            std::string m_spanName;
+            SmartPtr<SolverTimings> m_spTimings;
+        };
+
+    } // namespace RegressionTest
+} // namespace ug
+
+#endif /* UG4TESTS_REGRESSION_TESTS_TRACED_OPERATORS_H */
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef UG4TESTS_REGRESSION_TESTS_TRANSFER_BENCHMARK_H
+#define UG4TESTS_REGRESSION_TESTS_TRANSFER_BENCHMARK_H
+
+#include <chrono>
+#include <vector>
+
+#include "ug.h"
+#include "ugbase.h"
+#include "lib_disc/operator/linear_operator/std_transfer.h"
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Timings of the transfer between the levels lev - 1 and lev
+         */
+        struct TransferTimings
+        {
+            TransferTimings() : level(0), coarseDoFs(0), fineDoFs(0), setupSeconds(0.0), prolongateSeconds(0.0), restrictSeconds(0.0) {}
+
+            int level;
+            size_t coarseDoFs;
+            size_t fineDoFs;
+            /// initialization including the first prolongation and restriction
+            double setupSeconds;
+            /// mean time of one prolongation
+            double prolongateSeconds;
+            /// mean time of one restriction
+            double restrictSeconds;
+        };
+
+        /**
+         * \brief Measures setup and application of the transfer operators on all levels
+         *
+         * The StdTransfer is applied directly (the way the multigrid uses it) or, for
+         * assembled == true, the prolongation and restriction matrices are assembled once
+         * and applied as matrix-vector products. The results of the last application on
+         * each level are returned for comparisons between the variants. The timed
+         * restrictions include zeroing the coarse vector.
+         *
+         * \param[in]    spApproxSpace       approximation space with initialized levels
+         * \param[in]    p1Optimization      enables StdTransfer::enable_p1_lagrange_optimization
+         * \param[in]    assembled           use assembled transfer matrices
+         * \param[in]    numApply            number of timed applications per level
+         * \param[out]   prolongated         prolongation of a fixed coarse vector, per level
+         * \param[out]   restricted          restriction of a fixed fine vector, per level
+         * \return timings per level, starting with level 1
+         */
+        template <typename TDomain, typename TAlgebra>
+        std::vector<TransferTimings> BenchmarkTransfer(SmartPtr<ApproximationSpace<TDomain>> spApproxSpace, bool p1Optimization,
+                                                       bool assembled, int numApply,
+                                                       std::vector<std::vector<number>> &prolongated,
+                                                       std::vector<std::vector<number>> &restricted)
+        {
+            typedef GridFunction<TDomain, TAlgebra> TGridFunction;
+            typedef typename TAlgebra::matrix_type matrix_type;
+            typedef std::chrono::steady_clock clock;
+
+            spApproxSpace->init_levels();
+            const int numLevels = spApproxSpace->num_levels();
+
+            std::vector<TransferTimings> timings;
+            prolongated.clear();
+            restricted.clear();
+            for (int lev = 1; lev < numLevels; lev++)
+            {
+                const GridLevel coarseGL(lev - 1, GridLevel::LEVEL);
+                const GridLevel fineGL(lev, GridLevel::LEVEL);
+                TGridFunction uCoarse(spApproxSpace, coarseGL);
+                TGridFunction uFine(spApproxSpace, fineGL);
+
+                TransferTimings t;
+                t.level = lev;
+                t.coarseDoFs = uCoarse.size();
+                t.fineDoFs = uFine.size();
+
+                // deterministic input
+                for (size_t i = 0; i < uCoarse.size(); i++)
+                    uCoarse[i] = (number)i / uCoarse.size();
+
+                SmartPtr<StdTransfer<TDomain, TAlgebra>> transfer = make_sp(new StdTransfer<TDomain, TAlgebra>());
+                transfer->enable_p1_lagrange_optimization(p1Optimization);
+                SmartPtr<matrix_type> P, R;
+
+                clock::time_point start = clock::now();
+                if (assembled)
+                {
+                    P = transfer->prolongation(fineGL, coarseGL, spApproxSpace);
+                    R = transfer->restriction(coarseGL, fineGL, spApproxSpace);
+                    MatMult(uFine, 1.0, *P, uCoarse);
+                    MatMult(uCoarse, 1.0, *R, uFine);
+                }
+                else
+                {
+                    transfer->set_levels(coarseGL, fineGL);
+                    transfer->init();
+                    transfer->prolongate(uFine, uCoarse);
+                    transfer->do_restrict(uCoarse, uFine);
+                }
+                t.setupSeconds = std::chrono::duration<double>(clock::now() - start).count();
+
+                for (size_t i = 0; i < uCoarse.size(); i++)
+                    uCoarse[i] = (number)i / uCoarse.size();
+
+                start = clock::now();
+                for (int i = 0; i < numApply; i++)
+                {
+                    if (assembled)
+                        MatMult(uFine, 1.0, *P, uCoarse);
+                    else
+                        transfer->prolongate(uFine, uCoarse);
+                }
+                t.prolongateSeconds = std::chrono::duration<double>(clock::now() - start).count() / numApply;
+                prolongated.push_back(std::vector<number>(&uFine[0], &uFine[0] + uFine.size()));
+
+                SmartPtr<TGridFunction> spRestricted = uCoarse.clone_without_values();
+                start = clock::now();
+                for (int i = 0; i < numApply; i++)
+                {
+                    spRestricted->set(0.0);
+                    if (assembled)
+                        MatMult(*spRestricted, 1.0, *R, uFine);
+                    else
+                        transfer->do_restrict(*spRestricted, uFine);
+                }
+                t.restrictSeconds = std::chrono::duration<double>(clock::now() - start).count() / numApply;
+                restricted.push_back(std::vector<number>(&(*spRestricted)[0], &(*spRestricted)[0] + spRestricted->size()));
+
+                timings.push_back(t);
+            }
+            return timings;
+        }
+
+    } // namespace RegressionTest
+} // namespace ug
+
+#endif /* UG4TESTS_REGRESSION_TESTS_TRANSFER_BENCHMARK_H */
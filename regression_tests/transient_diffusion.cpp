@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#include <string>
+#include <vector>
+
+#include "ug.h"
+#include "ugbase.h"
+#include "lib_disc/time_disc/theta_time_step.h"
+#include "lib_disc/time_disc/solution_time_series.h"
+#include "../../ConvectionDiffusion/convection_diffusion_base.h"
+#include "../../ConvectionDiffusion/fv1/convection_diffusion_fv1.h"
+
+#include "testcase.h"
+#include "solver_setup.h"
+#include "convergence_history.h"
+
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Time-dependent diffusion testcase
+         *
+         * Solves the heat equation on the Laplace domain with the implicit Euler scheme
+         * for a fixed number of equidistant time steps. Since the time step size is
+         * constant, the system matrix and the GMG hierarchy are assembled and set up only
+         * once and reused in all steps, only the right-hand side is reassembled. With
+         * set_reuse_operator(false) both are rebuilt in every step, which gives the
+         * baseline for the time spent in redundant assembly and solver setup.
+         *
+         * \tparam dim Dimension of the problem
+         */
+        template <int dim>
+        class TransientDiffusion : public Testcase<dim>
+        {
+            typedef Testcase<dim> base_type;
+            typedef typename base_type::TAlgebra TAlgebra;
+            typedef typename base_type::vector_type vector_type;
+            typedef typename base_type::TDomain TDomain;
+            typedef typename base_type::TApproxSpace TApproxSpace;
+            typedef typename base_type::TDirichletBoundary TDirichletBoundary;
+            typedef typename base_type::TDomainDiscretization TDomainDiscretization;
+            typedef typename base_type::TGridFunction TGridFunction;
+            typedef ug::ConvectionDiffusionPlugin::ConvectionDiffusionFV1<TDomain> TConvDiff;
+            typedef ug::AssembledMultiGridCycle<TDomain, TAlgebra> GMG;
+            typedef ug::ThetaTimeStep<TAlgebra> TTimeDisc;
+
+        public:
+            /**
+             * Constructor
+             *
+             * \param[in]    grid        Name of the grid file
+             * \param[in]    reference   Name of the reference file
+             */
+            TransientDiffusion(std::string grid, std::string reference)
+                : base_type(grid, reference), m_numSteps(20), m_dt(0.01), m_bReuseOperator(true)
+            {
+            }
+
+            /**
+             * sets the number of time steps and the time step size
+             *
+             * \param[in]    numSteps    number of time steps
+             * \param[in]    dt          time step size
+             */
+            void set_time_steps(int numSteps, number dt)
+            {
+                m_numSteps = numSteps;
+                m_dt = dt;
+            }
+
+            /**
+             * \param[in]    reuse   if false, the operator is reassembled and the solver
+             *                       set up in every time step
+             */
+            void set_reuse_operator(bool reuse)
+            {
+                m_bReuseOperator = reuse;
+            }
+
+            /**
+             * Runs the time-dependent diffusion testcase
+             */
+            void run()
+            {
+                AlgebraType algebra("CPU", 1);
+                ug::bridge::InitUG(dim, algebra);
+
+                // Domain
+                this->m_spDomain = make_sp(new TDomain());
+                LoadDomain(*this->m_spDomain, this->m_gridname.c_str());
+                this->refine(this->m_numRefs);
+
+                // Approximation Space
+                this->m_spApproxSpace = make_sp(new TApproxSpace(this->m_spDomain));
+                this->m_spApproxSpace->add("c", "Lagrange", 1);
+                this->m_spApproxSpace->init_top_surface();
+
+                // Element Discretization with mass term for the time discretization
+                SmartPtr<TConvDiff> cd = make_sp(new TConvDiff("c", "Inner"));
+                cd->set_diffusion(1.0);
+                cd->set_reaction(0.0);
+                cd->set_mass_scale(1.0);
+                this->m_spElemDisc = cd;
+
+                // Dirichlet Boundary Conditions
+                SmartPtr<TDirichletBoundary> boundary = make_sp(new TDirichletBoundary());
+                boundary->add(-1, "c", "bndNegative");
+                boundary->add(1, "c", "bndPositive");
+
+                // Domain Discretization
+                this->m_spDomainDisc = make_sp(new TDomainDiscretization(this->m_spApproxSpace));
+                this->m_spDomainDisc->add(this->m_spElemDisc);
+                this->m_spDomainDisc->add(boundary);
+
+                // Time Discretization: implicit Euler
+                SmartPtr<TTimeDisc> timeDisc = make_sp(new TTimeDisc(this->m_spDomainDisc, 1.0));
+
+                // Geometric Multigrid Preconditioner
+                SmartPtr<GMG> gmg = CreateGMG<TDomain, TAlgebra>(this->m_spApproxSpace);
+
+                // Convergence Check
+                SmartPtr<TracedConvCheck<vector_type>> convCheck = make_sp(new TracedConvCheck<vector_type>(100, 1e-12, 1e-6, false));
+
+                // BiCGStab Solver
+                SmartPtr<BiCGStab<vector_type>> solver = make_sp(new BiCGStab<vector_type>());
+                solver->set_preconditioner(gmg);
+                solver->set_convergence_check(convCheck);
+
+                // Initial Value
+                m_spU = make_sp(new TGridFunction(this->m_spApproxSpace));
+                m_spB = make_sp(new TGridFunction(this->m_spApproxSpace));
+                m_spU->set(0.0);
+                this->m_spDomainDisc->adjust_solution(*m_spU);
+
+                const GridLevel gl = m_spU->grid_level();
+                m_spOp = make_sp(new AssembledLinearOperator<TAlgebra>(timeDisc, gl));
+
+                number time = 0.0;
+                SmartPtr<VectorTimeSeries<vector_type>> solTimeSeries = make_sp(new VectorTimeSeries<vector_type>());
+                solTimeSeries->push(m_spU->clone(), time);
+
+                // Time Stepping
+                m_numIterations = 0;
+                for (int step = 0; step < m_numSteps; step++)
+                {
+                    timeDisc->prepare_step(solTimeSeries, m_dt);
+
+                    if (step == 0 || !m_bReuseOperator)
+                    {
+                        this->start_phase("assembly");
+                        timeDisc->assemble_linear(*m_spOp, *m_spB, gl);
+                        this->stop_phase("assembly");
+
+                        this->start_phase("solver setup");
+                        solver->init(m_spOp, *m_spU);
+                        this->stop_phase("solver setup");
+                    }
+                    else
+                    {
+                        this->start_phase("assembly rhs");
+                        timeDisc->assemble_rhs(*m_spB, gl);
+                        this->stop_phase("assembly rhs");
+                    }
+
+                    this->start_phase("solve");
+                    if (!solver->apply(*m_spU, *m_spB))
+                        UG_THROW("TransientDiffusion: linear solver failed in step " << step << ".");
+                    this->stop_phase("solve");
+                    m_numIterations += convCheck->step();
+
+                    // push the new solution into the time series, reusing the oldest vector
+                    time += m_dt;
+                    SmartPtr<vector_type> oldest = solTimeSeries->oldest();
+                    *oldest = *m_spU;
+                    solTimeSeries->push_discard_oldest(oldest, time);
+                }
+
+                // Save Solution
+                this->store_solution(*m_spU);
+            }
+
+            /**
+             * \return total number of linear iterations over all time steps
+             */
+            int num_iterations() const
+            {
+                return m_numIterations;
+            }
+
+        protected:
+            SmartPtr<AssembledLinearOperator<TAlgebra>> m_spOp;
+            SmartPtr<TGridFunction> m_spU;
+            SmartPtr<TGridFunction> m_spB;
+            int m_numSteps;
+            number m_dt;
+            bool m_bReuseOperator;
+            int m_numIterations;
+        };
+
+    } // namespace RegressionTest
+} // namespace ug
@@ -39,17 +39,33 @@
 #include "unit_tests.cpp"
 #include "regression_tests.cpp"
 
-namespace ug {
-namespace test {
 int main(int argc, char *argv[])
 {
+    ug::test::ParseBenchmarkOptions(argc, argv);
+    ug::test::UpdateReferences() = ug::test::ParseFlagOption(argc, argv, "--update-references");
+    const std::string history = ug::test::ParseValueOption(argc, argv, "--history=");
+    const std::string trace = ug::test::ParseValueOption(argc, argv, "--trace=");
+    std::string profile = ug::test::ParseValueOption(argc, argv, "--profile=");
+    if (ug::test::ParseFlagOption(argc, argv, "--profile") && profile.empty())
+        profile = "ug4tests.folded";
+    const std::string profileFrequency = ug::test::ParseValueOption(argc, argv, "--profile-frequency=");
+    const bool energy = ug::test::ParseFlagOption(argc, argv, "--energy");
     ::testing::InitGoogleTest(&argc, argv);
 
+    // googletest takes the ownership of the listeners
+    ::testing::TestEventListeners &listeners = ::testing::UnitTest::GetInstance()->listeners();
+    if (!history.empty())
+        listeners.Append(new ug::test::HistoryRecorder(history));
+    if (!trace.empty())
+        listeners.Append(new ug::test::TraceRecorder(trace));
+    if (!profile.empty())
+        listeners.Append(new ug::test::SamplingProfiler(profile, profileFrequency.empty() ? 999 : std::atoi(profileFrequency.c_str())));
+    if (energy)
+        listeners.Append(new ug::test::EnergyMeter());
+
     int result;
     result = RUN_ALL_TESTS();
 
     return result;
 }
-} // namespace RegressionTest
-} // namespace ug
 
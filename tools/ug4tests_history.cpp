@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*
+ * ug4tests_history: trend analysis of the benchmark history written by
+ * ug4tests --history=<file>
+ *
+ * usage: ug4tests_history <file> [--filter=<substring>] [--min-shift=X] [--min-drift=X]
+ *                                [--threshold=X] [--all]
+ *
+ * Prints the change points and drifts of every time series (test, metric, compiler,
+ * flags and machine). With --all, series without findings are listed as well.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../regression_tests/benchmark_history.h"
+
+using namespace ug::test;
+
+namespace
+{
+    std::string FormatDate(long long time)
+    {
+        const std::time_t t = (std::time_t)time;
+        char buffer[32];
+        std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M", std::gmtime(&t));
+        return buffer;
+    }
+
+    std::string FormatNumber(double value, int precision, bool sign = false)
+    {
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(precision) << (sign ? std::showpos : std::noshowpos) << value;
+        return ss.str();
+    }
+
+    void PrintSeries(const std::vector<HistoryRecord> &records, const TrendAnalysis &analysis)
+    {
+        const HistoryRecord &last = records.back();
+        std::cout << last.test << "  " << last.metric << "\n"
+                  << "    " << last.compiler << " | " << last.flags << " | " << last.machine << "\n"
+                  << "    " << records.size() << " measurements from " << FormatDate(records.front().time) << " to "
+                  << FormatDate(last.time) << ", last " << last.value << " s (" << last.gitHash << ")\n";
+
+        for (const ChangePoint &cp : analysis.changePoints)
+        {
+            const HistoryRecord &before = records[cp.index - 1];
+            const HistoryRecord &after = records[cp.index];
+            std::cout << "    change point " << FormatNumber(100.0 * cp.shift, 1, true) << "% between " << before.gitHash
+                      << " (" << FormatDate(before.time) << ") and " << after.gitHash << " (" << FormatDate(after.time)
+                      << "), t = " << FormatNumber(cp.tStatistic, 1) << "\n";
+        }
+
+        if (analysis.driftSignificant)
+            std::cout << "    drift " << FormatNumber(100.0 * analysis.drift.perMonth, 2, true) << "% per month, t = "
+                      << FormatNumber(analysis.drift.tStatistic, 1) << "\n";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::string filename, filter;
+    TrendOptions options;
+    bool all = false;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        const std::string value = arg.substr(arg.find('=') + 1);
+        if (arg.compare(0, 9, "--filter=") == 0)
+            filter = value;
+        else if (arg.compare(0, 12, "--min-shift=") == 0)
+            options.minShift = std::atof(value.c_str());
+        else if (arg.compare(0, 12, "--min-drift=") == 0)
+            options.minDrift = std::atof(value.c_str());
+        else if (arg.compare(0, 12, "--threshold=") == 0)
+            options.threshold = std::atof(value.c_str());
+        else if (arg == "--all")
+            all = true;
+        else if (filename.empty() && arg.compare(0, 2, "--") != 0)
+            filename = arg;
+        else
+        {
+            std::cerr << "unknown argument '" << arg << "'" << std::endl;
+            return 2;
+        }
+    }
+
+    if (filename.empty())
+    {
+        std::cerr << "usage: ug4tests_history <file> [--filter=<substring>] [--min-shift=X] [--min-drift=X] "
+                     "[--threshold=X] [--all]"
+                  << std::endl;
+        return 2;
+    }
+
+    const std::vector<HistoryRecord> history = ReadHistory(filename);
+    if (history.empty())
+    {
+        std::cerr << "no records in '" << filename << "'" << std::endl;
+        return 1;
+    }
+
+    std::map<std::string, std::vector<HistoryRecord>> series;
+    for (const HistoryRecord &record : history)
+        if (filter.empty() || (record.test + " " + record.metric).find(filter) != std::string::npos)
+            series[record.series()].push_back(record);
+
+    int numFindings = 0;
+    for (std::map<std::string, std::vector<HistoryRecord>>::iterator it = series.begin(); it != series.end(); ++it)
+    {
+        std::vector<HistoryRecord> &records = it->second;
+        std::stable_sort(records.begin(), records.end(),
+                         [](const HistoryRecord &a, const HistoryRecord &b) { return a.time < b.time; });
+
+        std::vector<double> times, values;
+        for (const HistoryRecord &record : records)
+        {
+            times.push_back((double)record.time);
+            values.push_back(record.value);
+        }
+        const TrendAnalysis analysis = AnalyzeTrend(times, values, options);
+
+        const bool finding = !analysis.changePoints.empty() || analysis.driftSignificant;
+        numFindings += finding;
+        if (finding || all)
+            PrintSeries(records, analysis);
+    }
+
+    std::cout << series.size() << " series, " << numFindings << " with change points or drifts" << std::endl;
+    return 0;
+}
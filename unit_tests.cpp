@@ -30,4 +30,10 @@
  * GNU Lesser General Public License for more details.
  */
 
-#include "unit_tests/vector_tests.cpp"
\ No newline at end of file
+#include "unit_tests/vector_tests.cpp"
+#include "unit_tests/fused_kernel_tests.cpp"
+#include "unit_tests/benchmark_runner_tests.cpp"
+#include "unit_tests/benchmark_history_tests.cpp"
+#include "unit_tests/energy_meter_tests.cpp"
+#include "unit_tests/trace_recorder_tests.cpp"
+#include "unit_tests/sampling_profiler_tests.cpp"
\ No newline at end of file
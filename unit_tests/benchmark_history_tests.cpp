@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <vector>
+
+#include "../regression_tests/benchmark_history.h"
+
+namespace ug
+{
+    namespace test
+    {
+        /// deterministic noise of about +-0.5%
+        inline double HistoryNoise(size_t i)
+        {
+            const double pattern[] = {0.004, -0.003, 0.001, -0.005, 0.002, 0.005, -0.001, -0.004};
+            return pattern[i % 8];
+        }
+
+        TEST(BenchmarkHistory, RecordRoundTrip)
+        {
+            HistoryRecord record;
+            record.time = 1700000000;
+            record.gitHash = "abc1234";
+            record.compiler = "gcc 12.2";
+            record.flags = "Release -O3\t-march=native";
+            record.machine = "node01 / Xeon / 64 threads";
+            record.test = "Laplace.SmokeTests";
+            record.metric = "phase/solve";
+            record.value = 0.125;
+
+            std::ostringstream out;
+            WriteHistoryRecord(out, record);
+
+            HistoryRecord parsed;
+            ASSERT_TRUE(ParseHistoryRecord(out.str().substr(0, out.str().size() - 1), parsed));
+            EXPECT_EQ(parsed.time, record.time);
+            EXPECT_EQ(parsed.flags, "Release -O3 -march=native");
+            EXPECT_EQ(parsed.metric, record.metric);
+            EXPECT_DOUBLE_EQ(parsed.value, record.value);
+
+            EXPECT_FALSE(ParseHistoryRecord(HistoryHeader, parsed));
+            EXPECT_FALSE(ParseHistoryRecord("1700000000\tabc\t0.1", parsed));
+        }
+
+        TEST(BenchmarkHistory, StableSeries)
+        {
+            std::vector<double> times, values;
+            for (size_t i = 0; i < 40; i++)
+            {
+                times.push_back(1700000000.0 + 86400.0 * i);
+                values.push_back(1.0 + HistoryNoise(i));
+            }
+
+            const TrendAnalysis analysis = AnalyzeTrend(times, values);
+            EXPECT_TRUE(analysis.changePoints.empty());
+            EXPECT_FALSE(analysis.driftSignificant);
+        }
+
+        TEST(BenchmarkHistory, ChangePoint)
+        {
+            std::vector<double> times, values;
+            for (size_t i = 0; i < 40; i++)
+            {
+                times.push_back(1700000000.0 + 86400.0 * i);
+                values.push_back((i < 25 ? 1.0 : 1.1) * (1.0 + HistoryNoise(i)));
+            }
+
+            const TrendAnalysis analysis = AnalyzeTrend(times, values);
+            ASSERT_EQ(analysis.changePoints.size(), 1u);
+            EXPECT_EQ(analysis.changePoints[0].index, 25u);
+            EXPECT_NEAR(analysis.changePoints[0].shift, 0.1, 0.01);
+            EXPECT_FALSE(analysis.driftSignificant);
+        }
+
+        TEST(BenchmarkHistory, Drift)
+        {
+            // 2% per month over half a year, measured daily
+            std::vector<double> times, values;
+            for (size_t i = 0; i < 180; i++)
+            {
+                times.push_back(1700000000.0 + 86400.0 * i);
+                values.push_back(std::pow(1.02, i / 30.0) * (1.0 + HistoryNoise(i)));
+            }
+
+            const TrendAnalysis analysis = AnalyzeTrend(times, values);
+            EXPECT_TRUE(analysis.changePoints.empty());
+            EXPECT_TRUE(analysis.driftSignificant);
+            EXPECT_NEAR(analysis.drift.perMonth, 0.02, 0.002);
+        }
+
+    } // namespace RegressionTest
+} // namespace ug
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "../regression_tests/benchmark_runner.h"
+
+namespace ug
+{
+    namespace test
+    {
+
+        TEST(BenchmarkStatistics, Median)
+        {
+            EXPECT_DOUBLE_EQ(Median({3.0, 1.0, 2.0}), 2.0);
+            EXPECT_DOUBLE_EQ(Median({4.0, 1.0, 3.0, 2.0}), 2.5);
+            EXPECT_DOUBLE_EQ(Median({}), 0.0);
+        }
+
+        TEST(BenchmarkStatistics, Percentile)
+        {
+            const std::vector<double> values = {5.0, 1.0, 4.0, 2.0, 3.0};
+            EXPECT_DOUBLE_EQ(Percentile(values, 0.0), 1.0);
+            EXPECT_DOUBLE_EQ(Percentile(values, 50.0), 3.0);
+            EXPECT_DOUBLE_EQ(Percentile(values, 100.0), 5.0);
+            EXPECT_DOUBLE_EQ(Percentile(values, 95.0), 4.8);
+        }
+
+        TEST(BenchmarkStatistics, RejectOutliers)
+        {
+            std::vector<double> inliers;
+            EXPECT_EQ(RejectOutliers({1.0, 1.1, 0.9, 1.05, 0.95, 10.0}, 3.0, inliers), 1u);
+            EXPECT_EQ(inliers.size(), 5u);
+            for (double v : inliers)
+                EXPECT_LT(v, 2.0);
+
+            // identical samples have no spread and no outliers
+            EXPECT_EQ(RejectOutliers({2.0, 2.0, 2.0}, 3.0, inliers), 0u);
+        }
+
+        TEST(BenchmarkStatistics, MedianConfidenceInterval)
+        {
+            std::vector<double> values;
+            for (int i = 1; i <= 100; i++)
+                values.push_back(i);
+
+            double lower, upper;
+            MedianConfidenceInterval(values, lower, upper);
+            EXPECT_LE(lower, Median(values));
+            EXPECT_GE(upper, Median(values));
+            EXPECT_NEAR(lower, 41.0, 1.0);
+            EXPECT_NEAR(upper, 61.0, 1.0);
+        }
+
+        TEST(BenchmarkStatistics, SingleShotWithoutBenchmarkMode)
+        {
+            BenchmarkOptions options;
+            BenchmarkRunner runner(options);
+            int calls = 0;
+            const BenchmarkResult result = runner.run("single", [&calls]() { calls++; return 1.5; });
+            EXPECT_EQ(calls, 1);
+            EXPECT_DOUBLE_EQ(result.median, 1.5);
+        }
+
+        TEST(BenchmarkStatistics, RepeatsUntilConfidenceIntervalIsTight)
+        {
+            BenchmarkOptions options;
+            options.enabled = true;
+            options.pin = false;
+            options.numWarmup = 1;
+            options.minRepetitions = 5;
+            options.maxRepetitions = 100;
+            BenchmarkRunner runner(options);
+
+            int calls = 0;
+            const BenchmarkResult result = runner.run("constant", [&calls]() { calls++; return 1.0; });
+            EXPECT_TRUE(result.converged);
+            EXPECT_EQ(result.samples.size(), 5u);
+            EXPECT_EQ(calls, 6);
+            EXPECT_DOUBLE_EQ(result.median, 1.0);
+        }
+
+#ifdef __linux__
+        TEST(BenchmarkStatistics, RestoresThreadAffinity)
+        {
+            cpu_set_t before;
+            ASSERT_EQ(sched_getaffinity(0, sizeof(before), &before), 0);
+
+            BenchmarkOptions options;
+            options.enabled = true;
+            options.numWarmup = 0;
+            options.minRepetitions = 2;
+            options.maxRepetitions = 2;
+            BenchmarkRunner runner(options);
+
+            int pinnedCores = 0;
+            runner.run("pinned", [&pinnedCores]()
+                       {
+                           cpu_set_t set;
+                           sched_getaffinity(0, sizeof(set), &set);
+                           pinnedCores = CPU_COUNT(&set);
+                           return 1.0; });
+
+            cpu_set_t after;
+            ASSERT_EQ(sched_getaffinity(0, sizeof(after), &after), 0);
+            EXPECT_EQ(pinnedCores, 1);
+            EXPECT_TRUE(CPU_EQUAL(&before, &after));
+        }
+#endif
+
+    } // namespace test
+} // namespace ug
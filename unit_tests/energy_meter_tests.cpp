@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../regression_tests/energy_meter.h"
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief Temporary directory in the layout of /sys/class/powercap
+         */
+        class FakePowercap
+        {
+        public:
+            FakePowercap()
+            {
+                char dir[] = "/tmp/ug4tests_powercap_XXXXXX";
+                m_root = mkdtemp(dir);
+            }
+
+            ~FakePowercap()
+            {
+                for (std::vector<std::string>::reverse_iterator it = m_paths.rbegin(); it != m_paths.rend(); ++it)
+                    std::remove(it->c_str());
+                rmdir(m_root.c_str());
+            }
+
+            const std::string &root() const
+            {
+                return m_root;
+            }
+
+            /// adds a zone, without energy_uj if energy is negative
+            void add_zone(const std::string &zone, const std::string &name, long long energy, long long range)
+            {
+                const std::string dir = m_root + "/" + zone;
+                mkdir(dir.c_str(), 0700);
+                m_paths.push_back(dir);
+                write(dir + "/name", name);
+                if (energy >= 0)
+                    write(dir + "/energy_uj", std::to_string(energy));
+                write(dir + "/max_energy_range_uj", std::to_string(range));
+            }
+
+            void write(const std::string &filename, const std::string &content)
+            {
+                std::ofstream(filename) << content << "\n";
+                m_paths.push_back(filename);
+            }
+
+        private:
+            std::string m_root;
+            std::vector<std::string> m_paths;
+        };
+
+        TEST(RaplCounters, Discovery)
+        {
+            FakePowercap powercap;
+            powercap.add_zone("intel-rapl:0", "package-0", 1000, 10000000);
+            powercap.add_zone("intel-rapl:0:0", "core", 500, 10000000);
+            powercap.add_zone("intel-rapl:0:1", "dram", 200, 10000000);
+            powercap.add_zone("intel-rapl:1", "psys", 3000, 10000000);
+
+            RaplCounters counters(powercap.root());
+            ASSERT_TRUE(counters.available());
+            EXPECT_EQ(counters.zone_names(), std::vector<std::string>({"package-0", "dram"}));
+
+            const RaplCounters::reading_type before = counters.read();
+            powercap.write(powercap.root() + "/intel-rapl:0/energy_uj", "3000000");
+            powercap.write(powercap.root() + "/intel-rapl:0:1/energy_uj", "100");
+            const RaplCounters::reading_type after = counters.read();
+
+            // the dram counter wrapped around
+            EXPECT_NEAR(counters.joules(before, after), 2.999 + 9.9999, 1e-9);
+        }
+
+        TEST(RaplCounters, Unavailable)
+        {
+            FakePowercap powercap;
+            EXPECT_FALSE(RaplCounters(powercap.root()).available());
+
+            powercap.add_zone("intel-rapl:0", "package-0", -1, 1000000);
+            RaplCounters counters(powercap.root());
+            EXPECT_FALSE(counters.available());
+            EXPECT_NE(counters.unavailable_reason().find("not readable"), std::string::npos);
+            EXPECT_DOUBLE_EQ(counters.joules(counters.read(), counters.read()), 0.0);
+        }
+
+    } // namespace RegressionTest
+} // namespace ug
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#include <gtest/gtest.h>
+
+#include "common/common.h"
+#include "common/math/ugmath.h"
+#include "lib_algebra/cpu_algebra_types.h"
+#include "../regression_tests/fused_kernels.h"
+
+namespace ug
+{
+    namespace test
+    {
+
+        class FusedKernelTests : public ::testing::Test
+        {
+        protected:
+            typedef CPUAlgebra::vector_type VectorType;
+            static const size_t size = 1000;
+
+            FusedKernelTests()
+            {
+                for (VectorType *v : {&a, &b, &c, &d, &e, &f, &g})
+                {
+                    v->resize(size);
+                    for (size_t i = 0; i < size; ++i)
+                        (*v)[i] = urand(-1.0, 1.0);
+                }
+            };
+
+            VectorType a, b, c, d, e, f, g;
+
+            static void copy(VectorType &dest, const VectorType &src)
+            {
+                dest.resize(src.size());
+                for (size_t i = 0; i < src.size(); ++i)
+                    dest[i] = src[i];
+            }
+        };
+
+        TEST_F(FusedKernelTests, LocalVecProd)
+        {
+            double expected = 0.0;
+            for (size_t i = 0; i < size; ++i)
+                expected += a[i] * b[i];
+
+            EXPECT_NEAR(LocalVecProd(a, b), expected, 1e-12);
+        }
+
+        TEST_F(FusedKernelTests, FusedVecProd)
+        {
+            double ab, cd;
+            FusedVecProd(a, b, c, d, ab, cd);
+
+            EXPECT_NEAR(ab, LocalVecProd(a, b), 1e-12);
+            EXPECT_NEAR(cd, LocalVecProd(c, d), 1e-12);
+
+            double d0, d1, d2, d3, d4;
+            FusedVecProd(a, b, c, d, e, f, d0, d1, d2);
+            EXPECT_NEAR(d0, LocalVecProd(a, b), 1e-12);
+            EXPECT_NEAR(d1, LocalVecProd(c, d), 1e-12);
+            EXPECT_NEAR(d2, LocalVecProd(e, f), 1e-12);
+
+            FusedVecProd(a, b, c, d, e, f, g, a, b, b, d0, d1, d2, d3, d4);
+            EXPECT_NEAR(d0, LocalVecProd(a, b), 1e-12);
+            EXPECT_NEAR(d1, LocalVecProd(c, d), 1e-12);
+            EXPECT_NEAR(d2, LocalVecProd(e, f), 1e-12);
+            EXPECT_NEAR(d3, LocalVecProd(g, a), 1e-12);
+            EXPECT_NEAR(d4, LocalVecProd(b, b), 1e-12);
+        }
+
+        TEST_F(FusedKernelTests, FusedBiCGStabUpdate)
+        {
+            // x = a, r = b, p = c, sHat = d, s = e, t = f, rStar = g
+            const double alpha = 0.7, omega = -0.3;
+            VectorType x, r;
+            copy(x, a);
+            copy(r, b);
+            double rr, rStarR;
+            FusedBiCGStabUpdate(x, r, alpha, c, omega, d, e, f, g, rr, rStarR);
+
+            double expectedRR = 0.0, expectedRStarR = 0.0;
+            for (size_t i = 0; i < size; ++i)
+            {
+                EXPECT_NEAR(x[i], a[i] + (alpha * c[i] + omega * d[i]), 1e-12);
+                EXPECT_DOUBLE_EQ(r[i], e[i] - omega * f[i]);
+                expectedRR += r[i] * r[i];
+                expectedRStarR += g[i] * r[i];
+            }
+            EXPECT_NEAR(rr, expectedRR, 1e-10);
+            EXPECT_NEAR(rStarR, expectedRStarR, 1e-10);
+        }
+
+        TEST_F(FusedKernelTests, FusedCGUpdate)
+        {
+            const double alpha = 1.3;
+            VectorType x, r;
+            copy(x, a);
+            copy(r, b);
+            const double rr = FusedCGUpdate(x, r, alpha, c, d);
+
+            for (size_t i = 0; i < size; ++i)
+            {
+                EXPECT_DOUBLE_EQ(x[i], a[i] + alpha * c[i]);
+                EXPECT_DOUBLE_EQ(r[i], b[i] - alpha * d[i]);
+            }
+            EXPECT_NEAR(rr, LocalVecProd(r, r), 1e-10);
+        }
+
+    } // namespace test
+} // namespace ug
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../regression_tests/sampling_profiler.h"
+
+#ifdef __linux__
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief SamplingProfiler parsing records of a synthetic ring buffer
+         */
+        class SamplingProfilerProbe : public SamplingProfiler
+        {
+        public:
+            explicit SamplingProfilerProbe(size_t bufferSize) : SamplingProfiler("")
+            {
+                m_bufferSize = bufferSize;
+            }
+
+            using SamplingProfiler::tag_at;
+
+            void add_tag(uint64_t time, const std::string &tag)
+            {
+                m_tags.push_back(std::make_pair(time, tag));
+            }
+
+            uint64_t read(const std::vector<char> &buffer, uint64_t tail, uint64_t head)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                return read_records(buffer.data(), tail, head);
+            }
+
+            size_t num_samples() const { return m_numSamples; }
+            size_t num_lost() const { return m_numLost; }
+
+            /// \return number of samples of the given tag and stack
+            size_t count(const std::string &tag, const std::vector<uint64_t> &stack) const
+            {
+                std::map<std::pair<std::string, std::vector<uint64_t>>, size_t>::const_iterator it =
+                    m_stacks.find(std::make_pair(tag, stack));
+                return it == m_stacks.end() ? 0 : it->second;
+            }
+        };
+
+        /// writes the bytes at position pos of the ring buffer, wrapping around its end
+        static void PutRecord(std::vector<char> &buffer, uint64_t pos, const std::vector<uint64_t> &body, uint32_t type)
+        {
+            perf_event_header header;
+            header.type = type;
+            header.misc = 0;
+            header.size = (uint16_t)(sizeof(header) + body.size() * sizeof(uint64_t));
+
+            std::vector<char> bytes(header.size);
+            std::memcpy(bytes.data(), &header, sizeof(header));
+            std::memcpy(bytes.data() + sizeof(header), body.data(), body.size() * sizeof(uint64_t));
+            for (size_t i = 0; i < bytes.size(); i++)
+                buffer[(pos + i) % buffer.size()] = bytes[i];
+        }
+
+        /// \return body of a sample record: pid/tid, time, number of frames, frames
+        static std::vector<uint64_t> SampleBody(uint64_t time, const std::vector<uint64_t> &ips)
+        {
+            std::vector<uint64_t> body = {1, time, ips.size()};
+            body.insert(body.end(), ips.begin(), ips.end());
+            return body;
+        }
+
+        TEST(SamplingProfiler, TagAt)
+        {
+            SamplingProfilerProbe profiler(256);
+            profiler.add_tag(100, "Suite.a");
+            profiler.add_tag(200, "Suite.b;solve");
+
+            EXPECT_EQ(profiler.tag_at(50), "");
+            EXPECT_EQ(profiler.tag_at(100), "Suite.a");
+            EXPECT_EQ(profiler.tag_at(199), "Suite.a");
+            EXPECT_EQ(profiler.tag_at(200), "Suite.b;solve");
+            EXPECT_EQ(profiler.tag_at(1000), "Suite.b;solve");
+        }
+
+        TEST(SamplingProfiler, ParsesWrappedSample)
+        {
+            SamplingProfilerProbe profiler(256);
+            profiler.add_tag(100, "Suite.a");
+            profiler.add_tag(200, "Suite.b");
+
+            std::vector<char> buffer(256);
+            const std::vector<uint64_t> body = SampleBody(250, {0x10, (uint64_t)PERF_CONTEXT_USER, 0x20});
+            const uint64_t tail = 3 * 256 + 240;
+            PutRecord(buffer, tail, body, PERF_RECORD_SAMPLE);
+            const uint64_t head = tail + sizeof(perf_event_header) + body.size() * sizeof(uint64_t);
+
+            EXPECT_EQ(profiler.read(buffer, tail, head), head);
+            EXPECT_EQ(profiler.num_samples(), 1u);
+            EXPECT_EQ(profiler.count("Suite.b", {0x10, 0x20}), 1u);
+        }
+
+        TEST(SamplingProfiler, CountsLostSamples)
+        {
+            SamplingProfilerProbe profiler(256);
+            profiler.add_tag(100, "Suite.a");
+
+            std::vector<char> buffer(256);
+            PutRecord(buffer, 0, {7, 42}, PERF_RECORD_LOST);
+            PutRecord(buffer, 24, SampleBody(150, {0x10}), PERF_RECORD_SAMPLE);
+            PutRecord(buffer, 64, {7, 3}, PERF_RECORD_LOST);
+
+            EXPECT_EQ(profiler.read(buffer, 0, 88), 88u);
+            EXPECT_EQ(profiler.num_lost(), 45u);
+            EXPECT_EQ(profiler.num_samples(), 1u);
+        }
+
+        TEST(SamplingProfiler, StopsAtIncompleteRecord)
+        {
+            SamplingProfilerProbe profiler(256);
+            profiler.add_tag(100, "Suite.a");
+
+            std::vector<char> buffer(256);
+            PutRecord(buffer, 0, SampleBody(150, {0x10}), PERF_RECORD_SAMPLE);
+            PutRecord(buffer, 40, SampleBody(160, {0x10}), PERF_RECORD_SAMPLE);
+
+            // the kernel has written only part of the second record yet
+            EXPECT_EQ(profiler.read(buffer, 0, 60), 40u);
+            EXPECT_EQ(profiler.num_samples(), 1u);
+
+            EXPECT_EQ(profiler.read(buffer, 40, 80), 80u);
+            EXPECT_EQ(profiler.count("Suite.a", {0x10}), 2u);
+        }
+
+        TEST(SamplingProfiler, DropsUntaggedSamples)
+        {
+            SamplingProfilerProbe profiler(256);
+            profiler.add_tag(100, "Suite.a");
+            profiler.add_tag(200, "");
+
+            std::vector<char> buffer(256);
+            PutRecord(buffer, 0, SampleBody(50, {0x10}), PERF_RECORD_SAMPLE);
+            PutRecord(buffer, 40, SampleBody(250, {0x10}), PERF_RECORD_SAMPLE);
+            PutRecord(buffer, 80, SampleBody(150, {0x10}), PERF_RECORD_SAMPLE);
+
+            EXPECT_EQ(profiler.read(buffer, 0, 120), 120u);
+            EXPECT_EQ(profiler.num_samples(), 1u);
+            EXPECT_EQ(profiler.count("Suite.a", {0x10}), 1u);
+        }
+
+    } // namespace test
+} // namespace ug
+
+#endif
\ No newline at end of file
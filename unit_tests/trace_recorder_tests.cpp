@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2023:  G-CSC, Goethe University Frankfurt
+ * Author: Niklas Conen
+ * 
+ * This file is part of UG4.
+ * 
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ * 
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+#include "../regression_tests/trace_recorder.h"
+
+namespace ug
+{
+    namespace test
+    {
+        /**
+         * \brief TraceRecorder with access to its events and output
+         */
+        class TraceRecorderProbe : public TraceRecorder
+        {
+        public:
+            explicit TraceRecorderProbe(const std::string &filename) : TraceRecorder(filename) {}
+
+            using TraceRecorder::write;
+
+            /// \return the events as "B name" and "E name", separated by ", "
+            std::string events(int thread = 0) const
+            {
+                std::string list;
+                for (const Event &event : m_events)
+                {
+                    if (event.thread != thread)
+                        continue;
+                    if (!list.empty())
+                        list += ", ";
+                    list += std::string(1, event.type) + " " + event.name;
+                }
+                return list;
+            }
+        };
+
+        /**
+         * \brief Minimal JSON syntax check of the trace output
+         */
+        class JsonChecker
+        {
+        public:
+            explicit JsonChecker(const std::string &text) : m_text(text), m_pos(0) {}
+
+            /// \return true if the text is exactly one valid JSON value
+            bool valid()
+            {
+                m_pos = 0;
+                if (!value())
+                    return false;
+                skip_space();
+                return m_pos == m_text.size();
+            }
+
+        private:
+            void skip_space()
+            {
+                while (m_pos < m_text.size() && (m_text[m_pos] == ' ' || m_text[m_pos] == '\n' || m_text[m_pos] == '\t' || m_text[m_pos] == '\r'))
+                    m_pos++;
+            }
+
+            bool accept(char c)
+            {
+                skip_space();
+                if (m_pos < m_text.size() && m_text[m_pos] == c)
+                {
+                    m_pos++;
+                    return true;
+                }
+                return false;
+            }
+
+            bool value()
+            {
+                skip_space();
+                if (m_pos >= m_text.size())
+                    return false;
+                const char c = m_text[m_pos];
+                if (c == '{')
+                    return object();
+                if (c == '[')
+                    return array();
+                if (c == '"')
+                    return string();
+                return number();
+            }
+
+            bool object()
+            {
+                accept('{');
+                if (accept('}'))
+                    return true;
+                do
+                {
+                    skip_space();
+                    if (!string() || !accept(':') || !value())
+                        return false;
+                } while (accept(','));
+                return accept('}');
+            }
+
+            bool array()
+            {
+                accept('[');
+                if (accept(']'))
+                    return true;
+                do
+                {
+                    if (!value())
+                        return false;
+                } while (accept(','));
+                return accept(']');
+            }
+
+            bool string()
+            {
+                if (m_pos >= m_text.size() || m_text[m_pos] != '"')
+                    return false;
+                for (m_pos++; m_pos < m_text.size(); m_pos++)
+                {
+                    const char c = m_text[m_pos];
+                    if (c == '"')
+                    {
+                        m_pos++;
+                        return true;
+                    }
+                    if ((unsigned char)c < 0x20)
+                        return false;
+                    if (c == '\\')
+                    {
+                        m_pos++;
+                        if (m_pos >= m_text.size() || std::string("\"\\/bfnrtu").find(m_text[m_pos]) == std::string::npos)
+                            return false;
+                    }
+                }
+                return false;
+            }
+
+            bool number()
+            {
+                const char *begin = m_text.c_str() + m_pos;
+                char *end = nullptr;
+                std::strtod(begin, &end);
+                if (end == begin)
+                    return false;
+                m_pos += end - begin;
+                return true;
+            }
+
+            std::string m_text;
+            size_t m_pos;
+        };
+
+        TEST(TraceRecorder, JsonEscape)
+        {
+            EXPECT_EQ(JsonEscape("smoother setup (4913 rows)"), "smoother setup (4913 rows)");
+            EXPECT_EQ(JsonEscape("a \"quoted\" name"), "a \\\"quoted\\\" name");
+            EXPECT_EQ(JsonEscape("C:\\path"), "C:\\\\path");
+            EXPECT_EQ(JsonEscape("line\nbreak\t"), "line\\u000abreak\\u0009");
+        }
+
+        TEST(TraceRecorder, RepairsNesting)
+        {
+            TraceRecorderProbe recorder("unused.json");
+
+            // an end without begin is ignored
+            recorder.span_stopped("never started");
+            EXPECT_EQ(recorder.events(), "");
+
+            // ending an outer event closes the inner ones left open, e.g. by an exception
+            recorder.phase_started("solve");
+            recorder.span_started("iteration");
+            recorder.span_started("smooth");
+            recorder.phase_stopped("solve", 1.0);
+            EXPECT_EQ(recorder.events(), "B solve, B iteration, B smooth, E smooth, E iteration, E solve");
+
+            // the late end of an inner event is ignored then
+            recorder.span_stopped("smooth");
+            EXPECT_EQ(recorder.events(), "B solve, B iteration, B smooth, E smooth, E iteration, E solve");
+        }
+
+        TEST(TraceRecorder, NestsPerThread)
+        {
+            TraceRecorderProbe recorder("unused.json");
+            recorder.phase_started("solve");
+            std::thread worker([&recorder]()
+                               {
+                                   recorder.span_started("Galerkin product rows");
+                                   recorder.span_stopped("Galerkin product rows"); });
+            worker.join();
+            recorder.phase_stopped("solve", 1.0);
+
+            EXPECT_EQ(recorder.events(0), "B solve, E solve");
+            EXPECT_EQ(recorder.events(1), "B Galerkin product rows, E Galerkin product rows");
+        }
+
+        TEST(TraceRecorder, WritesValidJson)
+        {
+            char filename[] = "/tmp/ug4tests_trace_XXXXXX";
+            int fd = mkstemp(filename);
+            ASSERT_NE(fd, -1);
+            close(fd);
+
+            {
+                TraceRecorderProbe recorder(filename);
+                recorder.phase_started("assembly");
+                recorder.span_started("level \"1\"\n");
+                recorder.span_stopped("level \"1\"\n");
+                recorder.phase_stopped("assembly", 1.0);
+                recorder.write();
+            }
+
+            std::ifstream in(filename);
+            std::stringstream text;
+            text << in.rdbuf();
+            std::remove(filename);
+
+            EXPECT_TRUE(JsonChecker(text.str()).valid()) << text.str();
+            EXPECT_NE(text.str().find("\"traceEvents\""), std::string::npos);
+            EXPECT_NE(text.str().find("\"name\":\"level \\\"1\\\"\\u000a\""), std::string::npos);
+            EXPECT_FALSE(JsonChecker("{\"a\":[1,2,}").valid());
+        }
+
+    } // namespace test
+} // namespace ug
\ No newline at end of file